@@ -0,0 +1,283 @@
+/*
+ * TFlashImage.h
+ *
+ *	Образ flash МК из файла Intel HEX и запись в него CRC (TFlashCrc).
+ */
+
+#ifndef TFLASHIMAGE_H_
+#define TFLASHIMAGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "../inc/TFlashCrc.h"
+
+/**	\brief Образ flash МК.
+ *
+ *	Читается и записывается в формате Intel HEX (записи 00, 01, 02, 04;
+ *	записи 03 и 05 сохраняются без изменений). Незаписанные байты - 0xFF.
+ *	stamp() находит в образе запись TFlashCrc::SStamp и заполняет ее
+ *	так же, как ее проверяет TFlashCrc на МК.
+ */
+class TFlashImage {
+
+public:
+	/// Размер flash ATmega128.
+	static const uint32_t FLASH_SIZE = 0x20000;
+
+	/// Байт по адресу flash.
+	std::vector<uint8_t> data;
+
+	TFlashImage() : data(FLASH_SIZE, 0xFF), used(FLASH_SIZE, false) {}
+
+	/**	Чтение файла Intel HEX.
+	 *
+	 *	@param path Имя файла.
+	 *	@return False - ошибка чтения или формата.
+	 */
+	bool read(const char *path) {
+		FILE *f = fopen(path, "r");
+		char line[600];
+		uint32_t base = 0;
+		bool ok = (f != 0);
+
+		while (ok && (fgets(line, sizeof(line), f) != 0)) {
+			std::vector<uint8_t> rec;
+
+			if ((line[0] == '\n') || (line[0] == '\r'))
+				continue;
+			if (!parse(line, rec)) {
+				ok = false;
+				break;
+			}
+
+			uint32_t adr = base + ((rec[1] << 8) | rec[2]);
+			switch(rec[3]) {
+				case 0x00:
+					if (adr + rec[0] > FLASH_SIZE) {
+						ok = false;
+					} else {
+						put(adr, &rec[4], rec[0]);
+					}
+					break;
+				case 0x01:
+					break;
+				case 0x02:
+					base = ((rec[4] << 8) | rec[5]) << 4;
+					break;
+				case 0x04:
+					base = ((rec[4] << 8) | rec[5]) << 16;
+					break;
+				default:
+					start.push_back(rec);
+					break;
+			}
+		}
+
+		if (f != 0) {
+			fclose(f);
+		}
+		return ok;
+	}
+
+	/**	Запись файла Intel HEX, по 16 байт данных в записи.
+	 *
+	 *	@param path Имя файла.
+	 *	@return False - ошибка записи.
+	 */
+	bool write(const char *path) const {
+		FILE *f = fopen(path, "w");
+		uint32_t base = 0;
+
+		if (f == 0)
+			return false;
+
+		for(uint32_t adr = 0; adr < FLASH_SIZE;) {
+			if (!used[adr]) {
+				adr++;
+				continue;
+			}
+
+			if ((adr & 0xFFFF0000UL) != base) {
+				base = adr & 0xFFFF0000UL;
+				uint8_t ela[] = { 0x02, 0x00, 0x00, 0x04,
+						static_cast<uint8_t> (base >> 24),
+						static_cast<uint8_t> (base >> 16) };
+				print(f, ela, sizeof(ela));
+			}
+
+			std::vector<uint8_t> rec(4);
+			rec[1] = adr >> 8;
+			rec[2] = adr;
+			rec[3] = 0x00;
+			for(; (rec.size() < 4 + 16) && (adr < base + 0x10000UL) &&
+					used[adr]; adr++) {
+				rec.push_back(data[adr]);
+			}
+			rec[0] = rec.size() - 4;
+			print(f, &rec[0], rec.size());
+		}
+
+		for(size_t i = 0; i < start.size(); i++) {
+			print(f, &start[i][0], start[i].size());
+		}
+		uint8_t eof[] = { 0x00, 0x00, 0x00, 0x01 };
+		print(f, eof, sizeof(eof));
+
+		return fclose(f) == 0;
+	}
+
+	/**	Запись байт в образ.
+	 *
+	 *	@param adr Адрес flash.
+	 *	@param p Байты.
+	 *	@param n Кол-во байт.
+	 */
+	void put(uint32_t adr, const void *p, size_t n) {
+		for(size_t i = 0; i < n; i++) {
+			data[adr + i] = static_cast<const uint8_t*> (p)[i];
+			used[adr + i] = true;
+		}
+	}
+
+	/// Адрес после последнего записанного байта образа.
+	uint32_t getEnd() const {
+		uint32_t end = FLASH_SIZE;
+
+		while ((end != 0) && !used[end - 1]) {
+			end--;
+		}
+		return end;
+	}
+
+	/**	Поиск записи TFlashCrc::SStamp (по признаку, с шагом 2 байта).
+	 *
+	 *	@return Адрес записи, -1 - записи нет или их несколько.
+	 */
+	long findStamp() const {
+		long adr = -1;
+
+		for(uint32_t i = 0; i + sizeof(TFlashCrc::SStamp) <= FLASH_SIZE;
+				i += 2) {
+			if (get32(i) == TFlashCrc::MAGIC) {
+				if (adr >= 0)
+					return -1;
+				adr = i;
+			}
+		}
+		return adr;
+	}
+
+	/**	Заполнение записи TFlashCrc::SStamp.
+	 *
+	 *	Длина образа - getEnd(), CRC-32 (zlib) - по адресам [0, длина) без
+	 *	поля \a crc записи.
+	 *
+	 *	@param adr Адрес записи (findStamp()).
+	 *	@return Ошибка или пустая строка.
+	 */
+	std::string stamp(uint32_t adr) {
+		uint32_t field = adr + offsetof(TFlashCrc::SStamp, crc);
+		uint32_t len = getEnd();
+
+		if (len > 0x10000UL)
+			return "image is larger than 64K";
+		if (len < field + 4)
+			return "stamp is outside the image";
+
+		set32(adr + offsetof(TFlashCrc::SStamp, len), len);
+
+		uint32_t crc = 0xFFFFFFFFUL;
+		for(uint32_t i = 0; i < len; i++) {
+			if ((i < field) || (i >= field + 4)) {
+				crc = addCrc32(crc, data[i]);
+			}
+		}
+		set32(field, ~crc);
+
+		return "";
+	}
+
+	/// 4 байта образа, младший байт первым.
+	uint32_t get32(uint32_t adr) const {
+		return data[adr] | (data[adr + 1] << 8) | (data[adr + 2] << 16) |
+				(static_cast<uint32_t> (data[adr + 3]) << 24);
+	}
+
+	/// Запись 4 байт в образ, младший байт первым.
+	void set32(uint32_t adr, uint32_t val) {
+		uint8_t b[] = { static_cast<uint8_t> (val),
+				static_cast<uint8_t> (val >> 8),
+				static_cast<uint8_t> (val >> 16),
+				static_cast<uint8_t> (val >> 24) };
+		put(adr, b, sizeof(b));
+	}
+
+private:
+	std::vector<bool> used;						///< Записанные байты.
+	std::vector<std::vector<uint8_t> > start;	///< Записи 03 и 05.
+
+	/**	CRC-32 (zlib) побитно, независимо от таблиц TCrc.
+	 *
+	 *	@param crc Текущее значение.
+	 *	@param val Байт.
+	 *	@return Новое значение.
+	 */
+	static uint32_t addCrc32(uint32_t crc, uint8_t val) {
+		crc ^= val;
+		for(int i = 0; i < 8; i++) {
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320UL : 0);
+		}
+		return crc;
+	}
+
+	/**	Разбор строки записи.
+	 *
+	 *	@param line Строка.
+	 *	@param[out] rec Байты записи без контрольной суммы.
+	 *	@return False - ошибка формата или контрольной суммы.
+	 */
+	static bool parse(const char *line, std::vector<uint8_t> &rec) {
+		uint8_t sum = 0;
+		unsigned val;
+
+		if (line[0] != ':')
+			return false;
+
+		for(const char *p = line + 1; sscanf(p, "%2x", &val) == 1; p += 2) {
+			rec.push_back(val);
+			sum += val;
+			if ((rec.size() > 4) && (rec.size() == rec[0] + 5U))
+				break;
+		}
+
+		if ((rec.size() < 5) || (rec.size() != rec[0] + 5U) || (sum != 0))
+			return false;
+
+		rec.pop_back();
+		return true;
+	}
+
+	/**	Вывод записи с контрольной суммой.
+	 *
+	 *	@param f Файл.
+	 *	@param rec Байты записи.
+	 *	@param n Кол-во байт.
+	 */
+	static void print(FILE *f, const uint8_t *rec, size_t n) {
+		uint8_t sum = 0;
+
+		fprintf(f, ":");
+		for(size_t i = 0; i < n; i++) {
+			fprintf(f, "%02X", rec[i]);
+			sum += rec[i];
+		}
+		fprintf(f, "%02X\n", static_cast<uint8_t> (-sum));
+	}
+};
+
+#endif /* TFLASHIMAGE_H_ */
@@ -0,0 +1,693 @@
+/*
+ * TReportDecoder.h
+ *
+ *	Расшифровка кадров результатов тестов, переданных по USART1 (TReport).
+ */
+
+#ifndef TREPORTDECODER_H_
+#define TREPORTDECODER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../inc/TFlashCrc.h"
+#include "../inc/TReport.h"
+#include "../inc/TTests.h"
+
+/// Названия тестов.
+static const char * const testName[TTests::TEST_MAX] = {
+		"testError",
+		"testSoutBus",
+		"testRegPlis",
+		"testDataBus",
+		"testFram",
+		"test2Ram",
+		"testExtBus",
+		"testBusBench",
+		"testStress"
+};
+
+/// Названия областей внешней шины (TTests::BUS_AREA).
+static const char * const busAreaName[TTests::BUS_AREA_MAX] = {
+		"2ram",
+		"fram",
+		"plis"
+};
+
+/**	\brief Расшифровка потока кадров TReport.
+ *
+ *	Байты потока передаются по одному в put(). Поток может начинаться с
+ *	середины кадра, кадры с неверной CRC отбрасываются, после чего
+ *	ищется следующий байт SYNC. Пропущенные кадры определяются по номеру.
+ */
+class TReportDecoder {
+
+public:
+	/// Кадр.
+	struct SFrame {
+		uint8_t len;		///< Кол-во байт данных.
+		uint8_t seq;		///< Номер кадра.
+		uint8_t type;		///< Тип кадра (TReport::TYPE).
+		uint8_t data[255];	///< Данные.
+	};
+
+	/// Результат теста (кадр TReport::TYPE_RESULT).
+	struct SResult {
+		uint8_t test;		///< Номер теста.
+		uint8_t error;		///< Код ошибки.
+		uint16_t adr;		///< Адрес ошибки.
+		uint16_t ticks;		///< Длительность теста, тиков.
+	};
+
+	/// Статистика теста (кадр TReport::TYPE_STAT).
+	struct SStat {
+		uint8_t test;		///< Номер теста.
+		uint32_t busy;		///< Такты МК выполнения шагов.
+		uint32_t wait;		///< Такты МК ожидания между шагами.
+		uint32_t bus;		///< Обращений к внешней шине.
+	};
+
+	/// Время установления шины BusR (кадр TReport::TYPE_SETTLE).
+	struct SSettle {
+		uint16_t timeout;	///< Таймаут ожидания, тактов МК.
+		uint16_t bit[8];	///< Время установления разрядов, тактов МК.
+	};
+
+	/// Причина сброса МК (кадр TReport::TYPE_RESET).
+	struct SReset {
+		uint8_t cause;		///< Значение MCUCSR.
+		bool resumed;		///< Тесты продолжены с контрольной точки.
+		uint8_t test;		///< Тест контрольной точки.
+		uint8_t step;		///< Выполнено шагов теста.
+		uint8_t error;		///< Код ошибки теста.
+		uint8_t resumes;	///< Продолжений подряд.
+	};
+
+	/// Ошибки теста (кадр TReport::TYPE_FAIL).
+	struct SFail {
+		uint8_t test;		///< Номер теста.
+		uint16_t fails;		///< Кол-во ошибок.
+		uint16_t lost;		///< Ошибок вне записей.
+		uint8_t mask;		///< Разряды всех ошибок.
+		uint8_t num;		///< Кол-во записей.
+		TFailLog::SRun run[(255 - 6) / 5];	///< Записи.
+	};
+
+	/// Подбор тактов ожидания внешней шины (кадр TReport::TYPE_SWEEP).
+	struct SSweep {
+		uint8_t wait;		///< Текущие такты ожидания.
+		uint8_t divs;		///< Кол-во делителей частоты.
+		uint8_t div[8];		///< Делители частоты МК.
+		uint8_t areas;		///< Кол-во областей шины.
+		uint8_t pass[8][8];	///< Маски тактов ожидания [область][делитель].
+	};
+
+	/// Пропускная способность внешней шины (кадр TReport::TYPE_BENCH).
+	struct SBench {
+		uint8_t area;		///< Область шины (TTests::BUS_AREA).
+		uint16_t bytes;		///< Кол-во байт замера.
+		uint8_t kinds;		///< Кол-во видов обращений.
+		uint32_t cycles[TBusBench::KIND_MAX];	///< Время замера, тактов МК.
+	};
+
+	/// Проверка FRAM при нагрузке на шину (кадр TReport::TYPE_STRESS).
+	struct SStress {
+		uint32_t quiet;		///< Проход без нагрузки, тактов МК.
+		uint32_t loaded;	///< Проход с нагрузкой, тактов МК.
+		uint32_t calls;		///< Кол-во прерываний нагрузки.
+		uint16_t ramErrors;	///< Ошибки 2RAM в прерывании.
+		uint16_t regErrors;	///< Ошибки регистра ПЛИС в прерывании.
+	};
+
+	/// Быстрая самопроверка при запуске (кадр TReport::TYPE_POST).
+	struct SPost {
+		uint8_t error;		///< Код ошибки (TTests::post()).
+		uint32_t cycles;	///< Время самопроверки, тактов МК.
+		uint32_t bus;		///< Обращения к внешней шине.
+	};
+
+	/// План тестов (кадр TReport::TYPE_PLAN).
+	struct SPlan {
+		uint8_t first;		///< Первый тест итерации, TEST_ERROR - плана нет.
+		uint8_t last;		///< Последний тест итерации.
+		uint8_t flags;		///< Флаги (TTests::PLAN_FLAG).
+		uint16_t count;		///< Кол-во итераций, 0 - без ограничения.
+		uint32_t iter;		///< Законченные итерации, 0 - план принят.
+		uint32_t failed;	///< Итерации с ошибками.
+		uint16_t mask;		///< Тесты с ошибками в последней итерации.
+		uint32_t ticks;		///< Длительность последней итерации, тиков.
+		uint32_t bus;		///< Обращения к шине в последней итерации.
+	};
+
+	/// Проверка CRC программы во flash (кадр TReport::TYPE_FLASH).
+	struct SFlash {
+		uint8_t result;		///< Результат (TFlashCrc::RESULT).
+		uint32_t len;		///< Длина образа из записи.
+		uint32_t crc;		///< Вычисленная CRC-32.
+		uint32_t cycles;	///< Время проверки, тактов МК.
+	};
+
+	TReportDecoder() : state(STATE_SYNC), pos(0), crc(0), seq(0),
+			tickMs(TICK_MS), cpuMhz(F_CPU / 1000000UL), started(false), frames(0), crcErrors(0), lost(0) {
+		frame = SFrame();
+	}
+
+	/**	Обработка байта потока.
+	 *
+	 *	@param val Байт.
+	 *	@return True - если принят кадр с верной CRC (см. getFrame()).
+	 */
+	bool put(uint8_t val) {
+		bool ready = false;
+
+		if ((state != STATE_SYNC) && (state != STATE_CRC)) {
+			crc = TCrc::getCrc8(crc, val);
+		}
+
+		switch(state) {
+			case STATE_SYNC: {
+				if (val == TReport::SYNC) {
+					crc = 0;
+					state = STATE_LEN;
+				}
+			} break;
+
+			case STATE_LEN: {
+				frame.len = val;
+				state = STATE_SEQ;
+			} break;
+
+			case STATE_SEQ: {
+				frame.seq = val;
+				state = STATE_TYPE;
+			} break;
+
+			case STATE_TYPE: {
+				frame.type = val;
+				pos = 0;
+				state = (frame.len > 0) ? STATE_DATA : STATE_CRC;
+			} break;
+
+			case STATE_DATA: {
+				frame.data[pos++] = val;
+				if (pos >= frame.len) {
+					state = STATE_CRC;
+				}
+			} break;
+
+			case STATE_CRC: {
+				state = STATE_SYNC;
+				if (val != crc) {
+					crcErrors++;
+					return false;
+				}
+				ready = true;
+			} break;
+		}
+
+		if (ready) {
+			if (started && (frame.seq != static_cast<uint8_t> (seq + 1))) {
+				lost += static_cast<uint8_t> (frame.seq - seq - 1);
+			}
+			seq = frame.seq;
+			started = true;
+			frames++;
+
+			if ((frame.type == TReport::TYPE_START) && (frame.len >= 3)) {
+				tickMs = frame.data[1];
+				cpuMhz = frame.data[2];
+			}
+		}
+
+		return ready;
+	}
+
+	/// Последний принятый кадр.
+	const SFrame& getFrame() const {
+		return frame;
+	}
+
+	/**	Результат теста из последнего принятого кадра.
+	 *
+	 *	@param[out] res Результат теста.
+	 *	@return True - если последний кадр является результатом теста.
+	 */
+	bool getResult(SResult &res) const {
+		if ((frame.type != TReport::TYPE_RESULT) || (frame.len < 6))
+			return false;
+
+		res.test = frame.data[0];
+		res.error = frame.data[1];
+		res.adr = frame.data[2] | (frame.data[3] << 8);
+		res.ticks = frame.data[4] | (frame.data[5] << 8);
+		return true;
+	}
+
+	/**	Статистика теста из последнего принятого кадра.
+	 *
+	 *	@param[out] st Статистика теста.
+	 *	@return True - если последний кадр является статистикой теста.
+	 */
+	bool getStat(SStat &st) const {
+		if ((frame.type != TReport::TYPE_STAT) || (frame.len < 13))
+			return false;
+
+		st.test = frame.data[0];
+		st.busy = get32(&frame.data[1]);
+		st.wait = get32(&frame.data[5]);
+		st.bus = get32(&frame.data[9]);
+		return true;
+	}
+
+	/**	Время установления шины BusR из последнего принятого кадра.
+	 *
+	 *	@param[out] st Время установления.
+	 *	@return True - если последний кадр является временем установления.
+	 */
+	bool getSettle(SSettle &st) const {
+		if ((frame.type != TReport::TYPE_SETTLE) || (frame.len < 18))
+			return false;
+
+		st.timeout = frame.data[0] | (frame.data[1] << 8);
+		for(uint8_t i = 0; i < 8; i++) {
+			st.bit[i] = frame.data[2 + 2*i] | (frame.data[3 + 2*i] << 8);
+		}
+		return true;
+	}
+
+	/**	Причина сброса МК из последнего принятого кадра.
+	 *
+	 *	@param[out] rst Причина сброса.
+	 *	@return True - если последний кадр является причиной сброса.
+	 */
+	bool getReset(SReset &rst) const {
+		if ((frame.type != TReport::TYPE_RESET) || (frame.len < 6))
+			return false;
+
+		rst.cause = frame.data[0];
+		rst.resumed = (frame.data[1] != 0);
+		rst.test = frame.data[2];
+		rst.step = frame.data[3];
+		rst.error = frame.data[4];
+		rst.resumes = frame.data[5];
+		return true;
+	}
+
+	/**	Ошибки теста из последнего принятого кадра.
+	 *
+	 *	@param[out] fl Ошибки теста.
+	 *	@return True - если последний кадр является ошибками теста.
+	 */
+	bool getFail(SFail &fl) const {
+		if ((frame.type != TReport::TYPE_FAIL) || (frame.len < 6))
+			return false;
+
+		fl.test = frame.data[0];
+		fl.fails = frame.data[1] | (frame.data[2] << 8);
+		fl.lost = frame.data[3] | (frame.data[4] << 8);
+		fl.mask = frame.data[5];
+		fl.num = (frame.len - 6) / 5;
+		for(uint8_t i = 0; i < fl.num; i++) {
+			const uint8_t *p = &frame.data[6 + 5*i];
+			fl.run[i].adr = p[0] | (p[1] << 8);
+			fl.run[i].len = p[2] | (p[3] << 8);
+			fl.run[i].mask = p[4];
+		}
+		return true;
+	}
+
+	/**	Подбор тактов ожидания из последнего принятого кадра.
+	 *
+	 *	@param[out] sw Подбор тактов ожидания.
+	 *	@return True - если последний кадр является подбором тактов ожидания.
+	 */
+	bool getSweep(SSweep &sw) const {
+		if ((frame.type != TReport::TYPE_SWEEP) || (frame.len < 3))
+			return false;
+
+		sw.wait = frame.data[0];
+		sw.divs = frame.data[1];
+		if ((sw.divs > 8) || (frame.len < 3 + sw.divs))
+			return false;
+
+		for(uint8_t d = 0; d < sw.divs; d++) {
+			sw.div[d] = frame.data[2 + d];
+		}
+		sw.areas = frame.data[2 + sw.divs];
+		if ((sw.areas > 8) || (frame.len < 3 + sw.divs + sw.areas * sw.divs))
+			return false;
+
+		for(uint8_t a = 0; a < sw.areas; a++) {
+			for(uint8_t d = 0; d < sw.divs; d++) {
+				sw.pass[a][d] = frame.data[3 + sw.divs + a * sw.divs + d];
+			}
+		}
+		return true;
+	}
+
+	/**	Пропускная способность шины из последнего принятого кадра.
+	 *
+	 *	@param[out] bn Пропускная способность.
+	 *	@return True - если последний кадр является замером шины.
+	 */
+	bool getBench(SBench &bn) const {
+		if ((frame.type != TReport::TYPE_BENCH) || (frame.len < 4))
+			return false;
+
+		bn.area = frame.data[0];
+		bn.bytes = frame.data[1] | (frame.data[2] << 8);
+		bn.kinds = frame.data[3];
+		if ((bn.kinds > TBusBench::KIND_MAX) || (frame.len < 4 + 4 * bn.kinds))
+			return false;
+
+		for(uint8_t i = 0; i < bn.kinds; i++) {
+			bn.cycles[i] = get32(&frame.data[4 + 4 * i]);
+		}
+		return true;
+	}
+
+	/**	Пропускная способность для вида обращений.
+	 *
+	 *	@param bn Замер шины.
+	 *	@param kind Вид обращений TBusBench.
+	 *	@return Байт/с, 0 - время не измерено.
+	 */
+	double getBytesPerSec(const SBench &bn, uint8_t kind) const {
+		if ((kind >= bn.kinds) || (bn.cycles[kind] == 0))
+			return 0;
+
+		return bn.bytes * cpuMhz * 1e6 / bn.cycles[kind];
+	}
+
+	/**	Проверка FRAM при нагрузке на шину из последнего принятого кадра.
+	 *
+	 *	@param[out] ss Проверка при нагрузке.
+	 *	@return True - если последний кадр является проверкой при нагрузке.
+	 */
+	bool getStress(SStress &ss) const {
+		if ((frame.type != TReport::TYPE_STRESS) || (frame.len < 16))
+			return false;
+
+		ss.quiet = get32(&frame.data[0]);
+		ss.loaded = get32(&frame.data[4]);
+		ss.calls = get32(&frame.data[8]);
+		ss.ramErrors = frame.data[12] | (frame.data[13] << 8);
+		ss.regErrors = frame.data[14] | (frame.data[15] << 8);
+		return true;
+	}
+
+	/**	Самопроверка при запуске из последнего принятого кадра.
+	 *
+	 *	@param[out] ps Самопроверка.
+	 *	@return True - если последний кадр является самопроверкой.
+	 */
+	bool getPost(SPost &ps) const {
+		if ((frame.type != TReport::TYPE_POST) || (frame.len < 9))
+			return false;
+
+		ps.error = frame.data[0];
+		ps.cycles = get32(&frame.data[1]);
+		ps.bus = get32(&frame.data[5]);
+		return true;
+	}
+
+	/**	Проверка CRC программы из последнего принятого кадра.
+	 *
+	 *	@param[out] fc Проверка CRC.
+	 *	@return True - если последний кадр является проверкой CRC.
+	 */
+	bool getFlash(SFlash &fc) const {
+		if ((frame.type != TReport::TYPE_FLASH) || (frame.len < 13))
+			return false;
+
+		fc.result = frame.data[0];
+		fc.len = get32(&frame.data[1]);
+		fc.crc = get32(&frame.data[5]);
+		fc.cycles = get32(&frame.data[9]);
+		return true;
+	}
+
+	/**	План тестов из последнего принятого кадра.
+	 *
+	 *	@param[out] pl План.
+	 *	@return True - если последний кадр является планом тестов.
+	 */
+	bool getPlan(SPlan &pl) const {
+		if ((frame.type != TReport::TYPE_PLAN) || (frame.len < 23))
+			return false;
+
+		pl.first = frame.data[0];
+		pl.last = frame.data[1];
+		pl.flags = frame.data[2];
+		pl.count = frame.data[3] | (frame.data[4] << 8);
+		pl.iter = get32(&frame.data[5]);
+		pl.failed = get32(&frame.data[9]);
+		pl.mask = frame.data[13] | (frame.data[14] << 8);
+		pl.ticks = get32(&frame.data[15]);
+		pl.bus = get32(&frame.data[19]);
+		return true;
+	}
+
+	/**	Скорость обмена с внешней шиной в итерации плана.
+	 *
+	 *	@param pl План.
+	 *	@return Обращений к шине (байт) в секунду, 0 - итерации не было.
+	 */
+	double getPlanRate(const SPlan &pl) const {
+		return (pl.ticks != 0) ? pl.bus * 1000.0 / (pl.ticks * tickMs) : 0;
+	}
+
+	/**	Кадр команды для МК (TReport::CMD).
+	 *
+	 *	@param type Тип команды.
+	 *	@param data Данные.
+	 *	@param len Кол-во байт данных, не больше TReport::CMD_DATA_MAX.
+	 *	@param[out] buf Кадр, len + 5 байт.
+	 *	@return Кол-во байт кадра.
+	 */
+	static uint8_t makeCmd(uint8_t type, const uint8_t *data, uint8_t len,
+			uint8_t *buf) {
+		uint8_t crc = 0;
+
+		buf[0] = TReport::SYNC;
+		buf[1] = len;
+		buf[2] = 0;
+		buf[3] = type;
+		for(uint8_t i = 0; i < len; i++) {
+			buf[4 + i] = data[i];
+		}
+		for(uint8_t i = 1; i < 4 + len; i++) {
+			crc = TCrc::getCrc8(crc, buf[i]);
+		}
+		buf[4 + len] = crc;
+
+		return len + 5;
+	}
+
+	/**	Кадр команды выбора плана тестов (TReport::CMD_PLAN).
+	 *
+	 *	@param first Первый тест итерации, TEST_ERROR - без плана.
+	 *	@param last Последний тест итерации.
+	 *	@param count Кол-во итераций, 0 - без ограничения.
+	 *	@param flags Флаги (TTests::PLAN_FLAG).
+	 *	@param[out] buf Кадр, 10 байт.
+	 *	@return Кол-во байт кадра.
+	 */
+	static uint8_t makePlanCmd(uint8_t first, uint8_t last, uint16_t count,
+			uint8_t flags, uint8_t *buf) {
+		uint8_t data[] = { first, last, static_cast<uint8_t> (count),
+				static_cast<uint8_t> (count >> 8), flags };
+
+		return makeCmd(TReport::CMD_PLAN, data, sizeof(data), buf);
+	}
+
+	/**	Вывод последнего принятого кадра в текстовом виде, одной строкой.
+	 *
+	 *	@param f Файл.
+	 */
+	void print(FILE *f) const {
+		SResult res;
+		SStat st;
+		SSettle se;
+		SReset rst;
+		SFail fl;
+		SSweep sw;
+		SBench bn;
+		SStress ss;
+		SPost ps;
+		SFlash fc;
+		SPlan pl;
+
+		fprintf(f, "%3u ", frame.seq);
+		if (frame.type == TReport::TYPE_START) {
+			fprintf(f, "start version=%u tick_ms=%u mhz=%u\n",
+					(frame.len > 0) ? frame.data[0] : 0, tickMs, cpuMhz);
+		} else if (getResult(res)) {
+			fprintf(f, "%-12s %s error=0x%02X adr=0x%04X ms=%u\n",
+					(res.test < TTests::TEST_MAX) ? testName[res.test] : "?",
+					res.error ? "FAIL" : "pass", res.error, res.adr,
+					static_cast<unsigned> (res.ticks * tickMs));
+		} else if (getStat(st)) {
+			fprintf(f, "%-12s stat busy_ms=%.3f wait_ms=%.1f bus=%u\n",
+					(st.test < TTests::TEST_MAX) ? testName[st.test] : "?",
+					st.busy / (cpuMhz * 1000.0), st.wait / (cpuMhz * 1000.0),
+					st.bus);
+		} else if (getSettle(se)) {
+			fprintf(f, "%-12s settle_us", testName[TTests::TEST_DATA_BUS]);
+			for(uint8_t i = 0; i < 8; i++) {
+				if (se.bit[i] == TTests::DATA_BUS_FAIL) {
+					fprintf(f, " -");
+				} else {
+					fprintf(f, " %.2f", se.bit[i] / static_cast<double> (cpuMhz));
+				}
+			}
+			fprintf(f, " timeout_us=%.1f\n", se.timeout /
+					static_cast<double> (cpuMhz));
+		} else if (getReset(rst)) {
+			static const char * const causeName[] = {
+					"PORF", "EXTRF", "BORF", "WDRF", "JTRF"
+			};
+
+			fprintf(f, "reset cause=0x%02X", rst.cause);
+			for(uint8_t i = 0; i < 5; i++) {
+				if (rst.cause & (1 << i)) {
+					fprintf(f, " %s", causeName[i]);
+				}
+			}
+			if (rst.test == TTests::TEST_ERROR) {
+				// контрольной точки нет
+				fprintf(f, ", start\n");
+			} else {
+				fprintf(f, ", %s %s step=%u error=0x%02X resumes=%u\n",
+						rst.resumed ? "resume" : "start, last",
+						(rst.test < TTests::TEST_MAX) ? testName[rst.test] : "?",
+						rst.step, rst.error, rst.resumes);
+			}
+		} else if (getFail(fl)) {
+			fprintf(f, "%-12s fail count=%u lost=%u mask=0x%02X",
+					(fl.test < TTests::TEST_MAX) ? testName[fl.test] : "?",
+					fl.fails, fl.lost, fl.mask);
+			for(uint8_t i = 0; i < fl.num; i++) {
+				fprintf(f, " 0x%04X+%u:0x%02X", fl.run[i].adr, fl.run[i].len,
+						fl.run[i].mask);
+			}
+			fprintf(f, "\n");
+		} else if (getSweep(sw)) {
+			// для каждой области - наименьшие такты ожидания на каждом
+			// делителе частоты, '-' - ни одна настройка не прошла
+			fprintf(f, "sweep wait=%u", sw.wait);
+			for(uint8_t a = 0; a < sw.areas; a++) {
+				fprintf(f, " %s",
+						(a < TTests::BUS_AREA_MAX) ? busAreaName[a] : "?");
+				for(uint8_t d = 0; d < sw.divs; d++) {
+					uint8_t w = 0;
+
+					while ((w < 8) && !(sw.pass[a][d] & (1 << w))) {
+						w++;
+					}
+					if (w < 8) {
+						fprintf(f, " /%u:w%u", sw.div[d], w);
+					} else {
+						fprintf(f, " /%u:-", sw.div[d]);
+					}
+				}
+			}
+			fprintf(f, "\n");
+		} else if (getBench(bn)) {
+			static const char * const opName[TBusBench::OP_MAX] = {
+					"rd", "wr", "rmw"
+			};
+			static const char * const orderName[TBusBench::ORDER_MAX] = {
+					"seq", "rnd"
+			};
+
+			// КБ/с: цикл по байту / развернутый
+			fprintf(f, "%-12s %s kb/s", testName[TTests::TEST_BUS_BENCH],
+					(bn.area < TTests::BUS_AREA_MAX) ? busAreaName[bn.area] : "?");
+			for(uint8_t op = 0; op < TBusBench::OP_MAX; op++) {
+				for(uint8_t ord = 0; ord < TBusBench::ORDER_MAX; ord++) {
+					uint8_t k = TBusBench::getKind(
+							static_cast<TBusBench::OP> (op),
+							static_cast<TBusBench::ORDER> (ord),
+							TBusBench::LOOP_BYTE);
+
+					fprintf(f, " %s-%s=%.0f/%.0f", opName[op], orderName[ord],
+							getBytesPerSec(bn, k) / 1024,
+							getBytesPerSec(bn, k + 1) / 1024);
+				}
+			}
+			fprintf(f, "\n");
+		} else if (getStress(ss)) {
+			fprintf(f, "%-12s stress quiet_ms=%.1f loaded_ms=%.1f slowdown=%.1f%%"
+					" isr=%u ram_err=%u plis_err=%u\n",
+					testName[TTests::TEST_STRESS], ss.quiet / (cpuMhz * 1000.0),
+					ss.loaded / (cpuMhz * 1000.0), (ss.quiet != 0) ?
+							(ss.loaded * 100.0 / ss.quiet - 100.0) : 0.0,
+					ss.calls, ss.ramErrors, ss.regErrors);
+		} else if (getPost(ps)) {
+			fprintf(f, "%-12s %s error=0x%02X ms=%.1f bus=%u\n", "post",
+					(ps.error != 0) ? "FAIL" : "pass", ps.error,
+					ps.cycles / (cpuMhz * 1000.0), ps.bus);
+		} else if (getFlash(fc)) {
+			fprintf(f, "%-12s %s len=%u crc=0x%08X ms=%.1f\n", "flash",
+					(fc.result == TFlashCrc::RESULT_OK) ? "pass" :
+					(fc.result == TFlashCrc::RESULT_UNSTAMPED) ? "unstamped" :
+							"FAIL", fc.len, fc.crc,
+					fc.cycles / (cpuMhz * 1000.0));
+		} else if (getPlan(pl) && (pl.first == TTests::TEST_ERROR)) {
+			fprintf(f, "%-12s fsm\n", "plan");
+		} else if (getPlan(pl)) {
+			fprintf(f, "%-12s %s%s iter=%u/%u failed=%u %s..%s flags=0x%02X "
+					"mask=0x%04X ms=%u kb_s=%.1f\n", "plan",
+					(pl.iter == 0) ? "start" : (pl.mask != 0) ? "FAIL" : "pass",
+					(pl.flags & TTests::PLAN_DONE) ? " done" : "",
+					pl.iter, pl.count, pl.failed,
+					(pl.first < TTests::TEST_MAX) ? testName[pl.first] : "?",
+					(pl.last < TTests::TEST_MAX) ? testName[pl.last] : "?",
+					pl.flags, pl.mask, static_cast<unsigned> (pl.ticks * tickMs),
+					getPlanRate(pl) / 1024);
+		} else {
+			fprintf(f, "type=%u len=%u\n", frame.type, frame.len);
+		}
+	}
+
+	/// Кол-во принятых кадров.
+	uint32_t getFrames() const { return frames; }
+
+	/// Кол-во кадров с неверной CRC.
+	uint32_t getCrcErrors() const { return crcErrors; }
+
+	/// Кол-во пропущенных кадров (по номеру кадра).
+	uint32_t getLost() const { return lost; }
+
+private:
+	/// Состояния приема кадра
+	enum STATE {
+		STATE_SYNC,		///< Ожидание SYNC.
+		STATE_LEN,		///< Прием LEN.
+		STATE_SEQ,		///< Прием SEQ.
+		STATE_TYPE,		///< Прием TYPE.
+		STATE_DATA,		///< Прием данных.
+		STATE_CRC		///< Прием CRC.
+	};
+
+	/// Четыре байта кадра, младшим вперед.
+	static uint32_t get32(const uint8_t *p) {
+		return p[0] | (p[1] << 8) | (static_cast<uint32_t> (p[2]) << 16) |
+				(static_cast<uint32_t> (p[3]) << 24);
+	}
+
+	STATE state;		///< Состояние приема.
+	SFrame frame;		///< Принимаемый кадр.
+	uint8_t pos;		///< Кол-во принятых байт данных.
+	uint8_t crc;		///< CRC принимаемого кадра.
+	uint8_t seq;		///< Номер последнего кадра.
+	uint8_t tickMs;		///< Период тика тестов, мс.
+	uint8_t cpuMhz;		///< Частота МК, МГц.
+	bool started;		///< Принят хотя бы один кадр.
+	uint32_t frames;	///< Принято кадров.
+	uint32_t crcErrors;	///< Кадров с неверной CRC.
+	uint32_t lost;		///< Пропущено кадров.
+};
+
+#endif /* TREPORTDECODER_H_ */
@@ -0,0 +1,482 @@
+/*
+ * TSimBoard.cpp
+ *
+ *	Модель платы БСП для сборки тестов на ПК.
+ */
+#include <string.h>
+#include <unistd.h>
+
+#include "TSimBoard.h"
+
+/// Модель платы по умолчанию.
+static TSimBoard mainBoard;
+
+thread_local TSimBoard *simBoardCur = &mainBoard;
+
+TSimBoard::TSimBoard() :
+		udr1(TSimUartReg::REG_UDR), ucsr1a(TSimUartReg::REG_UCSRA),
+		ucsr1b(TSimUartReg::REG_UCSRB), ucsr1c(TSimUartReg::REG_UCSRC),
+		ubrr1h(TSimUartReg::REG_UBRRH), ubrr1l(TSimUartReg::REG_UBRRL),
+		flash(0x10000, 0xFF) {
+	flashStamp = 0;
+	tickPeriod = 0;
+	tickIsr = 0;
+	timer2Isr = 0;
+	uartFd = -1;
+	memset(busDelay, 0, sizeof(busDelay));
+	memset(accessNs, 0, sizeof(accessNs));
+	reset();
+}
+
+// Сброс платы
+void TSimBoard::reset() {
+	memset(space, 0, sizeof(space));
+	memset(plis, 0, sizeof(plis));
+	memset(&stat, 0, sizeof(stat));
+
+	portB.set(0);
+	portF.set(0);
+	plisVers = 0xFF;
+	sreg = 0;
+	mcucsr = 0x01;			// PORF, сброс по включению питания
+	busOld = 0;
+	busTime = 0;
+	xmcra = 0;
+	mcucr = 0;
+	xdiv = 0;
+
+	ucsr1a.set(1 << UART_UDRE);
+	ucsr1b.set(0);
+	ucsr1c.set(0x06);
+	ubrr1h.set(0);
+	ubrr1l.set(0);
+	tx.clear();
+	rx.clear();
+	txEnd = 0;
+
+	tickNext = tickPeriod;
+	timer2Period = 0;
+	timer2Next = 0;
+	inIsr = false;
+}
+
+// Установка прерывания таймера
+void TSimBoard::setTimer(uint32_t period, void (*isr)()) {
+	tickPeriod = period;
+	tickIsr = isr;
+	tickNext = stat.cycles + period;
+}
+
+// Чтение байта по внешней шине
+uint8_t TSimBoard::read(uint16_t adr) {
+	uint8_t val = 0xFF;
+
+	if (isShortStrobe(adr)) {
+		val = static_cast<uint8_t> (adr);
+	} else if ((adr >= RAM_ADR) && (adr < RAM_ADR + RAM_SIZE)) {
+		val = readMem(adr);
+	} else if ((adr >= PLIS_ADR) && (adr < PLIS_ADR + PLIS_SIZE)) {
+		if (faults.empty()) {
+			val = readPlis(adr - PLIS_ADR);
+		} else {
+			uint16_t cell = mapAdr(adr);
+			val = stuckBits(cell, readPlis(cell - PLIS_ADR));
+		}
+	} else if (adr >= FLASH_ADR) {
+		// FRAM доступна только после разрешения в регистре Init ПЛИС
+		if (plis[PLIS_INIT] == 0x55) {
+			val = readMem(adr);
+		}
+	}
+
+	stat.busRead++;
+	advance((CYCLES_EXT + getWait()) * getClkDiv());
+
+	return val;
+}
+
+// Запись байта по внешней шине
+void TSimBoard::write(uint16_t adr, uint8_t val) {
+	if (isShortStrobe(adr)) {
+		// данные не успели записаться
+	} else if ((adr >= RAM_ADR) && (adr < RAM_ADR + RAM_SIZE)) {
+		writeMem(adr, val);
+	} else if ((adr >= PLIS_ADR) && (adr < PLIS_ADR + PLIS_SIZE)) {
+		uint8_t reg = (faults.empty() ? adr : mapAdr(adr)) - PLIS_ADR;
+		if (reg == PLIS_BUS_W) {
+			busOld = getBusW();
+			busTime = stat.cycles;
+		}
+		plis[reg] = val;
+	} else if (adr >= FLASH_ADR) {
+		if (plis[PLIS_INIT] == 0x55) {
+			writeMem(adr, val);
+		}
+	}
+
+	stat.busWrite++;
+	advance((CYCLES_EXT + getWait()) * getClkDiv());
+}
+
+// Прерывание Timer2
+void TSimBoard::setTimer2(uint32_t period) {
+	timer2Period = period;
+	timer2Next = stat.cycles + period;
+}
+
+// Продвижение времени модели
+void TSimBoard::advance(uint32_t cycles) {
+	stat.cycles += cycles;
+
+	// прерывания не вложенные, Timer1 имеет больший приоритет
+	while (!inIsr) {
+		if ((tickIsr != 0) && (stat.cycles >= tickNext)) {
+			tickNext += tickPeriod;
+			inIsr = true;
+			tickIsr();
+			inIsr = false;
+		} else if ((timer2Isr != 0) && (timer2Period != 0) &&
+				(stat.cycles >= timer2Next)) {
+			timer2Next += timer2Period;
+			inIsr = true;
+			timer2Isr();
+			inIsr = false;
+		} else {
+			break;
+		}
+	}
+}
+
+// Спящий режим МК до следующего прерывания таймера
+void TSimBoard::sleep() {
+	uint64_t next = tickNext;
+
+	if ((timer2Isr != 0) && (timer2Period != 0) && (timer2Next < next)) {
+		next = timer2Next;
+	}
+
+	if ((tickIsr != 0) && (!inIsr) && (next > stat.cycles)) {
+		uint64_t cycles = next - stat.cycles;
+		stat.idle += cycles;
+		advance(cycles);
+	}
+}
+
+/**	Длительность передачи байта по USART1 (старт, 8 бит, стоп).
+ *
+ *	@return Кол-во тактов МК.
+ */
+uint32_t TSimBoard::getUartByte() const {
+	uint32_t ubrr = ((ubrr1h.get() & 0x0F) << 8) | ubrr1l.get();
+	uint32_t div = (ucsr1a.get() & (1 << UART_U2X)) ? 8 : 16;
+
+	return 10 * div * (ubrr + 1);
+}
+
+/**	Чтение регистра USART1.
+ *
+ *	Регистр данных передатчика освобождается, когда в сдвиговом регистре
+ *	остается не больше одного байта.
+ *
+ *	@param reg Регистр.
+ *	@return Значение регистра.
+ */
+uint8_t TSimBoard::uartRead(TSimUartReg::REG reg) {
+	uint8_t val = 0;
+
+	advance(CYCLES_PORT);
+
+	switch(reg) {
+		case TSimUartReg::REG_UDR: {
+			if (!rx.empty()) {
+				val = rx.front();
+				rx.pop_front();
+			}
+		} break;
+
+		case TSimUartReg::REG_UCSRA: {
+			val = ucsr1a.get() & ~((1 << UART_RXC) | (1 << UART_TXC) |
+					(1 << UART_UDRE));
+			if (!rx.empty()) {
+				val |= (1 << UART_RXC);
+			}
+			if (stat.cycles >= txEnd) {
+				val |= (1 << UART_TXC);
+			}
+			if (stat.cycles + getUartByte() >= txEnd) {
+				val |= (1 << UART_UDRE);
+			}
+		} break;
+
+		case TSimUartReg::REG_UCSRB: val = ucsr1b.get(); break;
+		case TSimUartReg::REG_UCSRC: val = ucsr1c.get(); break;
+		case TSimUartReg::REG_UBRRH: val = ubrr1h.get(); break;
+		case TSimUartReg::REG_UBRRL: val = ubrr1l.get(); break;
+	}
+
+	return val;
+}
+
+/**	Запись регистра USART1.
+ *
+ *	Запись в регистр данных при запрещенном передатчике игнорируется. Если
+ *	регистр данных еще занят, байт теряется, как и в МК.
+ *
+ *	@param reg Регистр.
+ *	@param val Значение.
+ */
+void TSimBoard::uartWrite(TSimUartReg::REG reg, uint8_t val) {
+	advance(CYCLES_PORT);
+
+	switch(reg) {
+		case TSimUartReg::REG_UDR: {
+			uint32_t byte = getUartByte();
+
+			if (!(ucsr1b.get() & (1 << UART_TXEN)))
+				break;
+
+			if (stat.cycles + byte < txEnd)
+				break;
+
+			txEnd = ((txEnd > stat.cycles) ? txEnd : stat.cycles) + byte;
+			tx.push_back(val);
+			stat.uartTx++;
+
+			if (uartFd >= 0) {
+				ssize_t n = ::write(uartFd, &val, 1);
+				(void) n;
+			}
+		} break;
+
+		case TSimUartReg::REG_UCSRA: ucsr1a.set(val); break;
+		case TSimUartReg::REG_UCSRB: ucsr1b.set(val); break;
+		case TSimUartReg::REG_UCSRC: ucsr1c.set(val); break;
+		case TSimUartReg::REG_UBRRH: ubrr1h.set(val); break;
+		case TSimUartReg::REG_UBRRL: ubrr1l.set(val); break;
+	}
+}
+
+/**	Кол-во тактов ожидания внешней шины (SRW11:SRW10).
+ *
+ *	Весь адрес внешней шины - один сектор (SRL = 0), поэтому учитываются
+ *	только такты ожидания верхнего сектора.
+ *
+ *	@return Дополнительные такты обращения к шине, 0..3.
+ */
+uint8_t TSimBoard::getWait() const {
+	return (((xmcra >> 1) & 1) << 1) | ((mcucr >> 6) & 1);
+}
+
+/**	Делитель частоты МК (XDIV).
+ *
+ *	@return Делитель, 1 - без деления.
+ */
+uint16_t TSimBoard::getClkDiv() const {
+	return (xdiv & 0x80) ? 129 - (xdiv & 0x7F) : 1;
+}
+
+/**	Проверка длительности строба RD/WR для области внешней шины.
+ *
+ *	Строб длится один такт МК и еще один или два при тактах ожидания
+ *	(при SRW = 3 третий такт ожидания идет до выставления адреса).
+ *
+ *	@param adr Адрес на шине.
+ *	@return True - строб короче минимального для области (accessNs).
+ */
+bool TSimBoard::isShortStrobe(uint16_t adr) const {
+	static const uint8_t STROBE[4] = { 1, 2, 3, 3 };
+	AREA area = AREA_FRAM;
+	uint64_t ns;
+
+	if ((adr >= RAM_ADR) && (adr < RAM_ADR + RAM_SIZE)) {
+		area = AREA_RAM;
+	} else if ((adr >= PLIS_ADR) && (adr < PLIS_ADR + PLIS_SIZE)) {
+		area = AREA_PLIS;
+	} else if (adr < FLASH_ADR) {
+		return false;
+	}
+
+	ns = STROBE[getWait()] * getClkDiv() * 1000000000ULL / F_CPU;
+
+	return ns < accessNs[area];
+}
+
+/**	Чтение регистра ПЛИС.
+ *
+ *	На проверочной плате шина BusW замкнута на BusR: BUSW0 -> BUSR3, ..,
+ *	BUSW3 -> BUSR0, старшие разряды без изменений. Шина доступна только
+ *	при разрешении работы с внешними устройствами в регистре ExtSet.
+ *
+ *	@param reg Смещение регистра.
+ *	@return Значение регистра.
+ */
+uint8_t TSimBoard::readPlis(uint8_t reg) const {
+	uint8_t val = plis[reg];
+
+	if (reg == PLIS_VERS) {
+		val = plisVers;
+	} else if (reg == PLIS_BUS_R) {
+		val = 0xFF;
+		if (plis[PLIS_EXT_SET] & (1 << 2)) {
+			uint8_t w = mapBusW(getBusW());
+			val = (w & 0xF0);
+			val += ((w & 1) << 3);
+			val += ((w & 2) << 1);
+			val += ((w & 4) >> 1);
+			val += ((w & 8) >> 3);
+		}
+	}
+
+	return val;
+}
+
+/**	Разряды BusW на входе BusR с учетом неисправностей FAULT_BUS_MAP.
+ *
+ *	@param val Значение на шине BusW.
+ *	@return Значение на входе BusR.
+ */
+uint8_t TSimBoard::mapBusW(uint8_t val) const {
+	for(size_t i = 0; i < faults.size(); i++) {
+		const SFault &f = faults[i];
+
+		if (f.type == FAULT_BUS_MAP) {
+			uint8_t diff = ((val >> f.line) ^ (val >> f.line2)) & 1;
+			val ^= (diff << f.line) | (diff << f.line2);
+		}
+	}
+
+	return val;
+}
+
+/**	Значение на шине BusW с учетом задержки распространения.
+ *
+ *	Разряд, измененный записью в регистр BusW, принимает новое значение
+ *	через \a busDelay тактов МК после записи.
+ *
+ *	@return Значение на шине.
+ */
+uint8_t TSimBoard::getBusW() const {
+	uint8_t val = plis[PLIS_BUS_W];
+	uint64_t dt = stat.cycles - busTime;
+
+	for(uint8_t bit = 0; bit < 8; bit++) {
+		if (dt < busDelay[bit]) {
+			val = (val & ~(1 << bit)) | (busOld & (1 << bit));
+		}
+	}
+
+	return val;
+}
+
+/**	Начало области памяти, в которой находится адрес.
+ *
+ *	@param adr Адрес 2RAM, FRAM или ПЛИС.
+ *	@return Начальный адрес 2RAM, FRAM или ПЛИС.
+ */
+uint16_t TSimBoard::getRegion(uint16_t adr) const {
+	if (adr >= FLASH_ADR)
+		return FLASH_ADR;
+
+	return (adr >= PLIS_ADR) ? PLIS_ADR : RAM_ADR;
+}
+
+/**	Адрес ячейки памяти с учетом неисправностей линий адреса.
+ *
+ *	@param adr Адрес на шине.
+ *	@return Адрес ячейки, к которой произойдет обращение.
+ */
+uint16_t TSimBoard::mapAdr(uint16_t adr) const {
+	uint16_t base = getRegion(adr);
+	uint16_t off = adr - base;
+
+	for(size_t i = 0; i < faults.size(); i++) {
+		const SFault &f = faults[i];
+
+		if ((f.type == FAULT_ALIAS) && (f.adr == adr)) {
+			off = f.adr2 - base;
+		}
+
+		if (f.adr != base)
+			continue;
+
+		if (f.type == FAULT_ADR_STUCK) {
+			off &= ~(1 << f.line);
+			off |= (f.val ? 1 : 0) << f.line;
+		} else if (f.type == FAULT_ADR_SHORT) {
+			uint16_t bit = ((off >> f.line) & (off >> f.line2)) & 1;
+			off &= ~((1 << f.line) | (1 << f.line2));
+			off |= (bit << f.line) | (bit << f.line2);
+		}
+	}
+
+	return base + off;
+}
+
+/**	Чтение ячейки памяти с учетом неисправностей.
+ *
+ *	@param adr Адрес на шине.
+ *	@return Значение.
+ */
+uint8_t TSimBoard::readMem(uint16_t adr) const {
+	if (faults.empty())
+		return space[adr];
+
+	uint16_t cell = mapAdr(adr);
+
+	return stuckBits(cell, space[cell]);
+}
+
+/**	Залипшие разряды данных при чтении ячейки.
+ *
+ *	@param cell Адрес ячейки (после mapAdr()).
+ *	@param val Значение ячейки.
+ *	@return Считанное значение.
+ */
+uint8_t TSimBoard::stuckBits(uint16_t cell, uint8_t val) const {
+	uint16_t base = getRegion(cell);
+
+	for(size_t i = 0; i < faults.size(); i++) {
+		const SFault &f = faults[i];
+
+		if (((f.type == FAULT_STUCK) && (f.adr == cell)) ||
+				((f.type == FAULT_DATA) && (f.adr == base))) {
+			val = (val & ~f.mask) | (f.val & f.mask);
+		}
+	}
+
+	return val;
+}
+
+/**	Запись ячейки памяти с учетом неисправностей.
+ *
+ *	@param adr Адрес на шине.
+ *	@param val Значение.
+ */
+void TSimBoard::writeMem(uint16_t adr, uint8_t val) {
+	if (faults.empty()) {
+		space[adr] = val;
+		return;
+	}
+
+	uint16_t cell = mapAdr(adr);
+	uint16_t base = getRegion(adr);
+	uint8_t old = space[cell];
+
+	for(size_t i = 0; i < faults.size(); i++) {
+		const SFault &f = faults[i];
+
+		if (((f.type == FAULT_STUCK) && (f.adr == cell)) ||
+				((f.type == FAULT_DATA) && (f.adr == base))) {
+			val = (val & ~f.mask) | (f.val & f.mask);
+		}
+	}
+	space[cell] = val;
+
+	for(size_t i = 0; i < faults.size(); i++) {
+		const SFault &f = faults[i];
+
+		if ((f.type == FAULT_COUPLING) && (f.adr2 == cell)) {
+			space[f.adr] ^= (old ^ val) & f.mask;
+		}
+	}
+}
@@ -0,0 +1,472 @@
+/*
+ * TSimBoard.h
+ *
+ *	Модель платы БСП для сборки тестов на ПК.
+ *
+ *	Модель хранит содержимое регистров ПЛИС, 2RAM и FRAM, состояние портов
+ *	светодиодов SOut и ведет счет тактов МК. Время в модели идет только за
+ *	счет обращений к шине, портам, flash и задержек, поэтому полученные
+ *	значения тактов - оценка снизу для реального МК.
+ */
+
+#ifndef TSIMBOARD_H_
+#define TSIMBOARD_H_
+
+#include <stdint.h>
+#include <deque>
+#include <type_traits>
+#include <vector>
+
+/**	\brief Порт ввода-вывода МК с подсчетом обращений.
+ *
+ */
+class TSimPort {
+
+public:
+	TSimPort() : val(0) {}
+
+	operator uint8_t() const;
+	void operator=(int v);
+	void operator|=(int v);
+	void operator&=(int v);
+	void operator^=(int v);
+
+	/// Значение порта без учета обращения (для модели).
+	uint8_t get() const { return val; }
+
+	/// Установка значения порта без учета обращения (для модели).
+	void set(uint8_t v) { val = v; }
+
+private:
+	uint8_t val;	///< Значение регистра порта.
+};
+
+/**	\brief Регистр USART МК модели.
+ *
+ *	Обращения к регистрам данных и состояния передаются в модель платы,
+ *	остальные регистры просто хранят значение.
+ */
+class TSimUartReg {
+
+public:
+	/// Регистры USART.
+	enum REG {
+		REG_UDR		= 0,	///< Данные.
+		REG_UCSRA	= 1,	///< Состояние.
+		REG_UCSRB	= 2,	///< Управление B.
+		REG_UCSRC	= 3,	///< Управление C.
+		REG_UBRRH	= 4,	///< Скорость, старший байт.
+		REG_UBRRL	= 5		///< Скорость, младший байт.
+	};
+
+	TSimUartReg(REG r) : reg(r), val(0) {}
+
+	operator uint8_t() const;
+	void operator=(int v);
+	void operator|=(int v) { *this = *this | v; }
+	void operator&=(int v) { *this = *this & v; }
+
+	/// Значение регистра без учета обращения (для модели).
+	uint8_t get() const { return val; }
+
+	/// Установка значения регистра без учета обращения (для модели).
+	void set(uint8_t v) { val = v; }
+
+private:
+	const REG reg;	///< Регистр.
+	uint8_t val;	///< Значение регистра.
+};
+
+/**	\brief Модель платы БСП.
+ *
+ *	Адресное пространство внешней шины представлено массивом \a space,
+ *	указатели на регистры внешних устройств указывают внутрь него. По адресу
+ *	элемента определяется устройство, к которому идет обращение.
+ */
+class TSimBoard {
+
+public:
+	// КАРТА ПАМЯТИ ПЛАТЫ
+	static const uint16_t RAM_ADR	 =	0x3000;		///< Начальный адрес 2RAM.
+	static const uint16_t RAM_SIZE	 =	0x0800;		///< Размер памяти 2RAM.
+	static const uint16_t PLIS_ADR   =	0x7000;		///< Начальный адрес ПЛИС.
+	static const uint16_t PLIS_SIZE  =	0x0010;		///< Размер области ПЛИС.
+	static const uint16_t FLASH_ADR  =	0x8000;		///< Начальный адрес FLASH.
+	static const uint16_t FLASH_SIZE =	0x8000;		///< Размер памяти FLASH.
+
+	/// Смещения регистров ПЛИС.
+	enum PLIS_REG {
+		PLIS_INIT		= 0,	///< Регистр Init.
+		PLIS_VERS		= 1,	///< Версия прошивки (только чтение).
+		PLIS_DD_L		= 2,	///< Регистр DD, младший байт.
+		PLIS_DD_H		= 3,	///< Регистр DD, старший байт.
+		PLIS_CUR_ADR	= 4,	///< Регистр CurAdr.
+		PLIS_EXT_SET	= 5,	///< Регистр ExtSet.
+		PLIS_BUS_R		= 6,	///< Регистр чтения шины BusR (только чтение).
+		PLIS_BUS_W		= 7,	///< Регистр записи шины BusW.
+		PLIS_BANK_FL	= 8,	///< Регистр BankFl.
+		PLIS_NULL		= 9		///< Регистр Null.
+	};
+
+	/// Области внешней шины.
+	enum AREA {
+		AREA_RAM	= 0,	///< 2RAM.
+		AREA_PLIS	= 1,	///< ПЛИС.
+		AREA_FRAM	= 2,	///< FRAM.
+		AREA_MAX			///< Кол-во областей.
+	};
+
+	// РАЗРЯДЫ РЕГИСТРОВ USART
+	static const uint8_t UART_RXC  = 7;		///< UCSRA, прием закончен.
+	static const uint8_t UART_TXC  = 6;		///< UCSRA, передача закончена.
+	static const uint8_t UART_UDRE = 5;		///< UCSRA, регистр данных пуст.
+	static const uint8_t UART_U2X  = 1;		///< UCSRA, удвоение скорости.
+	static const uint8_t UART_RXEN = 4;		///< UCSRB, разрешение приема.
+	static const uint8_t UART_TXEN = 3;		///< UCSRB, разрешение передачи.
+
+	// ДЛИТЕЛЬНОСТИ ОПЕРАЦИЙ В ТАКТАХ МК
+	static const uint8_t CYCLES_EXT  = 3;	///< LD/ST на внешней шине.
+	static const uint8_t CYCLES_PORT = 1;	///< Обращение к порту.
+	static const uint8_t CYCLES_PGM  = 3;	///< LPM, чтение flash.
+
+	/// Счетчики модели.
+	struct SStat {
+		uint64_t cycles;	///< Такты МК.
+		uint32_t busRead;	///< Чтения по внешней шине.
+		uint32_t busWrite;	///< Записи по внешней шине.
+		uint32_t port;		///< Обращения к портам SOut.
+		uint32_t pgm;		///< Чтения flash.
+		uint64_t idle;		///< Такты МК в спящем режиме.
+		uint32_t uartTx;	///< Переданные по USART1 байты.
+	};
+
+	/**	Неисправности памяти 2RAM, FRAM и регистров ПЛИС.
+	 *
+	 *	Область \a adr - RAM_ADR, FLASH_ADR или PLIS_ADR. Обрыв линии адреса
+	 *	моделируется FAULT_ADR_STUCK (подтяжка к 0 или 1), неисправность
+	 *	дешифратора адреса ПЛИС - FAULT_ADR_STUCK/FAULT_ADR_SHORT (регистры
+	 *	попарно совпадают) или FAULT_ALIAS (совпадают два регистра).
+	 */
+	enum FAULT {
+		FAULT_STUCK		= 0,	///< Разряды \a mask ячейки \a adr залипли в \a val.
+		FAULT_DATA		= 1,	///< Разряды \a mask всех ячеек области \a adr
+								///< залипли в \a val (линии данных).
+		FAULT_COUPLING	= 2,	///< Изменение разрядов \a mask ячейки \a adr2
+								///< инвертирует эти разряды в ячейке \a adr.
+		FAULT_ADR_STUCK	= 3,	///< Линия адреса \a line области \a adr
+								///< залипла в \a val.
+		FAULT_ADR_SHORT	= 4,	///< Линии адреса \a line и \a line2 области
+								///< \a adr замкнуты (монтажное И).
+		FAULT_ALIAS		= 5,	///< Обращение к ячейке \a adr выполняется к
+								///< ячейке \a adr2.
+		FAULT_BUS_MAP	= 6		///< Разряды \a line и \a line2 BusW
+								///< перепутаны на входе BusR.
+	};
+
+	/// Описание неисправности.
+	struct SFault {
+		uint8_t type;		///< Тип неисправности (FAULT).
+		uint16_t adr;		///< Адрес ячейки или начало области.
+		uint16_t adr2;		///< Адрес ячейки-агрессора.
+		uint8_t mask;		///< Разряды данных.
+		uint8_t val;		///< Значение залипания.
+		uint8_t line;		///< Линия адреса.
+		uint8_t line2;		///< Вторая линия адреса.
+	};
+
+	TSimBoard();
+
+	/// Сброс платы: очистка памяти, регистров и счетчиков.
+	void reset();
+
+	/**	Установка прерывания таймера.
+	 *
+	 *	@param period Период прерывания в тактах МК.
+	 *	@param isr Обработчик прерывания.
+	 */
+	void setTimer(uint32_t period, void (*isr)());
+
+	/**	Установка периода прерывания Timer2 (TBusStress).
+	 *
+	 *	@param period Период прерывания в тактах МК, 0 - прерывание
+	 *	запрещено.
+	 */
+	void setTimer2(uint32_t period);
+
+	/**	Установка обработчика прерывания Timer2.
+	 *
+	 *	@param isr Обработчик прерывания.
+	 */
+	void setTimer2Isr(void (*isr)()) {
+		timer2Isr = isr;
+	}
+
+	/// Чтение байта по внешней шине.
+	uint8_t read(uint16_t adr);
+
+	/// Запись байта по внешней шине.
+	void write(uint16_t adr, uint8_t val);
+
+	/// Учет обращения к порту.
+	void portAccess() {
+		stat.port++;
+		advance(CYCLES_PORT);
+	}
+
+	/// Чтение байта из flash МК.
+	uint8_t pgmRead(const void *p) {
+		stat.pgm++;
+		advance(CYCLES_PGM);
+		return *static_cast<const uint8_t*> (p);
+	}
+
+	/// Продвижение времени модели, с вызовом прерывания таймера.
+	void advance(uint32_t cycles);
+
+	/// Спящий режим МК до следующего прерывания таймера.
+	void sleep();
+
+	/// Чтение регистра USART1.
+	uint8_t uartRead(TSimUartReg::REG reg);
+
+	/// Запись регистра USART1.
+	void uartWrite(TSimUartReg::REG reg, uint8_t val);
+
+	/**	Вывод переданных по USART1 байт в файл (например, псевдотерминал).
+	 *
+	 *	@param fd Дескриптор файла, -1 - вывод не нужен.
+	 */
+	void setUartFd(int fd) {
+		uartFd = fd;
+	}
+
+	/// Байт для приема по USART1.
+	void uartRx(uint8_t val) {
+		rx.push_back(val);
+	}
+
+	/// Переданные по USART1 байты с последнего сброса платы.
+	const std::vector<uint8_t>& getUartTx() const {
+		return tx;
+	}
+
+	/// Добавление неисправности. Сохраняется при сбросе платы.
+	void addFault(const SFault &fault) {
+		faults.push_back(fault);
+	}
+
+	/// Удаление всех неисправностей.
+	void clearFaults() {
+		faults.clear();
+	}
+
+	/// Адрес на внешней шине для указателя внутрь \a space.
+	uint16_t getAdr(const volatile void *p) const {
+		return static_cast<uint16_t> (
+				static_cast<const volatile uint8_t*> (p) - space);
+	}
+
+	/// Значение выведенное на шину SOut (как в TSoutBus::setValue()).
+	uint8_t getSout() const {
+		return ((portB.get() ^ 0x80) & 0xF0) | (portF.get() & 0x0F);
+	}
+
+	/// Счетчики модели.
+	const SStat& getStat() const {
+		return stat;
+	}
+
+	uint8_t space[0x10000];		///< Адресное пространство внешней шины.
+	TSimPort portB;				///< Порт B (светодиоды SOut).
+	TSimPort portF;				///< Порт F (светодиоды SOut).
+	TSimUartReg udr1;			///< USART1, UDR1.
+	TSimUartReg ucsr1a;			///< USART1, UCSR1A.
+	TSimUartReg ucsr1b;			///< USART1, UCSR1B.
+	TSimUartReg ucsr1c;			///< USART1, UCSR1C.
+	TSimUartReg ubrr1h;			///< USART1, UBRR1H.
+	TSimUartReg ubrr1l;			///< USART1, UBRR1L.
+	uint8_t plisVers;			///< Версия прошивки ПЛИС.
+	uint8_t sreg;				///< SREG, флаг прерываний не моделируется.
+	uint8_t mcucsr;				///< MCUCSR, причина сброса МК.
+	/// Задержка BusW -> BusR по разрядам, тактов (reset() не меняет).
+	uint16_t busDelay[8];
+	uint8_t xmcra;				///< XMCRA, такты ожидания SRW11.
+	uint8_t mcucr;				///< MCUCR, такты ожидания SRW10.
+	uint8_t xdiv;				///< XDIV, делитель частоты МК.
+	/// Минимальная длительность строба RD/WR по областям (AREA), нс.
+	/// При более коротком стробе запись не выполняется, а при чтении
+	/// считывается младший байт адреса, оставшийся на шине AD (reset()
+	/// не меняет).
+	uint16_t accessNs[AREA_MAX];
+	/// Образ flash МК для TFlashCrc, 64 КБ (reset() не меняет). Сначала
+	/// стерт (0xFF), записи TFlashCrc::SStamp нет.
+	std::vector<uint8_t> flash;
+	/// Адрес записи TFlashCrc::SStamp в \a flash (reset() не меняет).
+	uint16_t flashStamp;
+
+private:
+	SStat stat;					///< Счетчики.
+	uint8_t plis[PLIS_SIZE];	///< Регистры ПЛИС.
+
+	uint32_t tickPeriod;		///< Период прерывания таймера, тактов.
+	uint64_t tickNext;			///< Время следующего прерывания таймера.
+	void (*tickIsr)();			///< Обработчик прерывания таймера.
+	uint32_t timer2Period;		///< Период прерывания Timer2, 0 - запрещено.
+	uint64_t timer2Next;		///< Время следующего прерывания Timer2.
+	void (*timer2Isr)();		///< Обработчик прерывания Timer2.
+	bool inIsr;					///< Флаг выполнения прерывания.
+
+	std::vector<SFault> faults;	///< Неисправности.
+
+	std::vector<uint8_t> tx;	///< Переданные по USART1 байты.
+	std::deque<uint8_t> rx;		///< Байты для приема по USART1.
+	uint64_t txEnd;				///< Время окончания передачи, такт МК.
+	int uartFd;					///< Файл вывода передачи USART1.
+
+	uint32_t getUartByte() const;
+
+	uint8_t busOld;				///< Значение шины BusW до записи.
+	uint64_t busTime;			///< Время записи в регистр BusW.
+
+	uint8_t getWait() const;
+	uint16_t getClkDiv() const;
+	bool isShortStrobe(uint16_t adr) const;
+	uint8_t readPlis(uint8_t reg) const;
+	uint8_t mapBusW(uint8_t val) const;
+	uint8_t getBusW() const;
+	uint16_t getRegion(uint16_t adr) const;
+	uint16_t mapAdr(uint16_t adr) const;
+	uint8_t stuckBits(uint16_t cell, uint8_t val) const;
+	uint8_t readMem(uint16_t adr) const;
+	void writeMem(uint16_t adr, uint8_t val);
+};
+
+/**	Модель платы текущего потока.
+ *
+ *	По умолчанию во всех потоках - одна общая модель. Для параллельной
+ *	работы (host/runner.cpp) поток устанавливает свою модель. Указатель,
+ *	а не объект thread_local, - обращение к нему не требует вызова
+ *	функции инициализации.
+ */
+extern thread_local TSimBoard *simBoardCur;
+
+/// Модель платы.
+#define simBoard (*simBoardCur)
+
+/// Кол-во байт занимаемых регистром типа T на шине.
+template <typename T>
+struct TSimWidth {
+	static const uint8_t value = std::is_enum<T>::value ? 1 : sizeof(T);
+};
+
+/**	\brief Регистр (ячейка памяти) на внешней шине модели.
+ *
+ *	Занимает на шине столько же байт, сколько и тип T в МК, все обращения
+ *	перенаправляются в модель платы. 16-битные значения записываются
+ *	старшим байтом вперед и считываются младшим вперед, как это делает
+ *	avr-gcc для volatile переменных.
+ */
+template <typename T>
+class TSimReg {
+
+public:
+	operator T() const volatile {
+		return static_cast<T> (get());
+	}
+
+	void operator=(T val) volatile {
+		set(static_cast<uint16_t> (val));
+	}
+
+	void operator|=(T val) volatile {
+		set(get() | static_cast<uint16_t> (val));
+	}
+
+	void operator&=(T val) volatile {
+		set(get() & static_cast<uint16_t> (val));
+	}
+
+	void operator^=(T val) volatile {
+		set(get() ^ static_cast<uint16_t> (val));
+	}
+
+private:
+	uint8_t raw[TSimWidth<T>::value];
+
+	uint16_t get() const volatile {
+		uint16_t adr = simBoard.getAdr(this);
+		uint16_t val = simBoard.read(adr);
+
+		if (TSimWidth<T>::value > 1) {
+			val |= simBoard.read(adr + 1) << 8;
+		}
+
+		return val;
+	}
+
+	void set(uint16_t val) volatile {
+		uint16_t adr = simBoard.getAdr(this);
+
+		if (TSimWidth<T>::value > 1) {
+			simBoard.write(adr + 1, val >> 8);
+		}
+		simBoard.write(adr, val);
+	}
+};
+
+/// Тип регистра (ячейки памяти) расположенного на внешней шине.
+#define EXT_REG(type) TSimReg<type>
+
+/**	Указатель на структуру расположенную во внешней памяти модели.
+ *
+ *	@param adr Адрес на внешней шине.
+ *	@return Указатель на структуру.
+ */
+template <typename T>
+inline volatile T* extPtr(uint16_t adr) {
+	return reinterpret_cast<volatile T*> (simBoard.space + adr);
+}
+
+/**	Адрес на внешней шине модели для указателя на регистр (ячейку памяти).
+ *
+ *	@param p Указатель.
+ *	@return Адрес.
+ */
+inline uint16_t extAdr(const volatile void *p) {
+	return simBoard.getAdr(p);
+}
+
+inline TSimPort::operator uint8_t() const {
+	simBoard.portAccess();
+	return val;
+}
+
+inline void TSimPort::operator=(int v) {
+	simBoard.portAccess();
+	val = static_cast<uint8_t> (v);
+}
+
+inline void TSimPort::operator|=(int v) {
+	simBoard.portAccess();
+	val |= v;
+}
+
+inline void TSimPort::operator&=(int v) {
+	simBoard.portAccess();
+	val &= v;
+}
+
+inline void TSimPort::operator^=(int v) {
+	simBoard.portAccess();
+	val ^= v;
+}
+
+inline TSimUartReg::operator uint8_t() const {
+	return simBoard.uartRead(reg);
+}
+
+inline void TSimUartReg::operator=(int v) {
+	simBoard.uartWrite(reg, static_cast<uint8_t> (v));
+}
+
+#endif /* TSIMBOARD_H_ */
@@ -0,0 +1,155 @@
+/*
+ * TStealPool.h
+ *
+ *	Пул потоков с перехватом заданий (work stealing).
+ */
+
+#ifndef TSTEALPOOL_H_
+#define TSTEALPOOL_H_
+
+#include <stddef.h>
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**	\brief Пул потоков с перехватом заданий.
+ *
+ *	Задания - номера 0..jobs-1, перед запуском раздаются потокам подряд
+ *	равными частями. Поток берет задания из конца своей очереди, а когда
+ *	она пуста - перехватывает из начала очереди другого потока. Новых
+ *	заданий во время работы не появляется, поэтому поток заканчивает
+ *	работу, когда пусты все очереди.
+ *
+ *	Задания разной длительности (исправная плата проходит все тесты,
+ *	неисправная останавливается на первой ошибке) так распределяются
+ *	между потоками без общего счетчика на каждое задание.
+ */
+class TStealPool {
+
+public:
+	/**	Задание.
+	 *
+	 *	@param job Номер задания.
+	 *	@param worker Номер потока, 0..getThreads()-1.
+	 */
+	typedef std::function<void(size_t job, unsigned worker)> TJob;
+
+	/**	Конструктор.
+	 *
+	 *	@param threads Кол-во потоков, 0 - по кол-ву ядер.
+	 */
+	explicit TStealPool(unsigned threads) : queue(0) {
+		if (threads == 0) {
+			threads = std::thread::hardware_concurrency();
+		}
+		this->threads = (threads != 0) ? threads : 1;
+		steals = 0;
+	}
+
+	/// Кол-во потоков.
+	unsigned getThreads() const {
+		return threads;
+	}
+
+	/// Кол-во перехваченных заданий за последний run().
+	size_t getSteals() const {
+		return steals;
+	}
+
+	/**	Выполнение заданий.
+	 *
+	 *	Возврат после выполнения всех заданий.
+	 *
+	 *	@param jobs Кол-во заданий.
+	 *	@param job Задание.
+	 */
+	void run(size_t jobs, const TJob &job) {
+		std::vector<SQueue> q(threads);
+		std::vector<std::thread> pool;
+
+		for(unsigned w = 0; w < threads; w++) {
+			for(size_t i = jobs * w / threads; i < jobs * (w + 1) / threads;
+					i++) {
+				q[w].jobs.push_back(i);
+			}
+		}
+		queue = &q;
+		steals = 0;
+
+		for(unsigned w = 1; w < threads; w++) {
+			pool.push_back(std::thread(&TStealPool::work, this, w,
+					std::cref(job)));
+		}
+		work(0, job);
+		for(size_t i = 0; i < pool.size(); i++) {
+			pool[i].join();
+		}
+
+		queue = 0;
+	}
+
+private:
+	/// Очередь заданий потока.
+	struct SQueue {
+		std::mutex lock;			///< Доступ к очереди.
+		std::deque<size_t> jobs;	///< Номера заданий.
+	};
+
+	unsigned threads;				///< Кол-во потоков.
+	std::vector<SQueue> *queue;		///< Очереди потоков во время run().
+	std::mutex stealLock;			///< Доступ к \a steals.
+	size_t steals;					///< Перехваченные задания.
+
+	/**	Работа потока.
+	 *
+	 *	@param worker Номер потока.
+	 *	@param job Задание.
+	 */
+	void work(unsigned worker, const TJob &job) {
+		size_t i;
+
+		while (pop(worker, i)) {
+			job(i, worker);
+		}
+	}
+
+	/**	Следующее задание потока.
+	 *
+	 *	@param worker Номер потока.
+	 *	@param[out] job Номер задания.
+	 *	@return False - заданий не осталось ни в одной очереди.
+	 */
+	bool pop(unsigned worker, size_t &job) {
+		std::vector<SQueue> &q = *queue;
+
+		{
+			std::lock_guard<std::mutex> l(q[worker].lock);
+			if (!q[worker].jobs.empty()) {
+				job = q[worker].jobs.back();
+				q[worker].jobs.pop_back();
+				return true;
+			}
+		}
+
+		for(unsigned n = 1; n < threads; n++) {
+			SQueue &v = q[(worker + n) % threads];
+			std::lock_guard<std::mutex> l(v.lock);
+
+			if (!v.jobs.empty()) {
+				job = v.jobs.front();
+				v.jobs.pop_front();
+
+				std::lock_guard<std::mutex> s(stealLock);
+				steals++;
+				return true;
+			}
+		}
+
+		return false;
+	}
+};
+
+#endif /* TSTEALPOOL_H_ */
@@ -0,0 +1,14 @@
+/*
+ * avr/interrupt.h
+ *
+ *	Замена avr/interrupt.h для сборки на ПК: прерывания вызывает модель
+ *	платы, глобальный флаг прерываний не моделируется.
+ */
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#define sei()
+#define cli()
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
@@ -0,0 +1,68 @@
+/*
+ * avr/io.h
+ *
+ *	Замена avr/io.h для сборки на ПК: порты светодиодов SOut, SREG, MCUCSR,
+ *	регистры внешней шины, XDIV и регистры USART1 берутся из модели платы.
+ */
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+#include "../TSimBoard.h"
+
+#define PORTB	(simBoard.portB)
+#define PORTF	(simBoard.portF)
+#define SREG	(simBoard.sreg)
+#define MCUCSR	(simBoard.mcucsr)
+
+#define JTRF	4
+#define WDRF	3
+#define BORF	2
+#define EXTRF	1
+#define PORF	0
+
+#define XMCRA	(simBoard.xmcra)
+#define MCUCR	(simBoard.mcucr)
+#define XDIV	(simBoard.xdiv)
+
+#define SRE		7
+#define SRW10	6
+#define SRW11	1
+#define XDIVEN	7
+
+#define PB0		0
+#define PB1		1
+#define PB2		2
+#define PB3		3
+#define PB4		4
+#define PB5		5
+#define PB6		6
+#define PB7		7
+
+#define PF0		0
+#define PF1		1
+#define PF2		2
+#define PF3		3
+#define PF4		4
+#define PF5		5
+#define PF6		6
+#define PF7		7
+
+#define UDR1	(simBoard.udr1)
+#define UCSR1A	(simBoard.ucsr1a)
+#define UCSR1B	(simBoard.ucsr1b)
+#define UCSR1C	(simBoard.ucsr1c)
+#define UBRR1H	(simBoard.ubrr1h)
+#define UBRR1L	(simBoard.ubrr1l)
+
+#define RXC1	7
+#define TXC1	6
+#define UDRE1	5
+#define U2X1	1
+#define RXEN1	4
+#define TXEN1	3
+#define UCSZ11	2
+#define UCSZ10	1
+
+#endif /* HOST_AVR_IO_H_ */
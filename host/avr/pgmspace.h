@@ -0,0 +1,49 @@
+/*
+ * avr/pgmspace.h
+ *
+ *	Замена avr/pgmspace.h для сборки на ПК: данные "во flash" лежат в
+ *	обычной памяти, чтения учитываются моделью платы.
+ */
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../TSimBoard.h"
+
+#define PROGMEM
+
+/// Чтение байта из flash.
+static inline uint8_t pgm_read_byte(const void *p) {
+	return simBoard.pgmRead(p);
+}
+
+/// Чтение двух байт из flash.
+static inline uint16_t pgm_read_word(const void *p) {
+	const uint8_t *s = static_cast<const uint8_t*> (p);
+
+	return simBoard.pgmRead(s) | (simBoard.pgmRead(s + 1) << 8);
+}
+
+/// Чтение четырех байт из flash.
+static inline uint32_t pgm_read_dword(const void *p) {
+	const uint8_t *s = static_cast<const uint8_t*> (p);
+
+	return pgm_read_word(s) |
+			(static_cast<uint32_t> (pgm_read_word(s + 2)) << 16);
+}
+
+/// Копирование блока из flash.
+static inline void *memcpy_P(void *dst, const void *src, size_t n) {
+	uint8_t *d = static_cast<uint8_t*> (dst);
+	const uint8_t *s = static_cast<const uint8_t*> (src);
+
+	for(size_t i = 0; i < n; i++) {
+		d[i] = simBoard.pgmRead(s + i);
+	}
+
+	return dst;
+}
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
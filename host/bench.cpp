@@ -0,0 +1,1769 @@
+/*
+ * bench.cpp
+ *
+ *	Замер времени выполнения тестов TTests на модели платы.
+ *
+ *	Проходит последовательность тестов FSM от TEST_SOUT_BUS до TEST_EXT_BUS
+ *	и для каждого теста выводит время МК, кол-во обращений к внешней шине,
+ *	портам SOut, flash и время выполнения на ПК. Повтор теста означает
+ *	обнаруженную ошибку, в этом случае программа возвращает 1.
+ *
+ *	Кадры результатов, переданные тестами по USART1, расшифровываются и
+ *	сверяются с кол-вом тестов. С ключом -u <файл> поток USART1 по ходу
+ *	тестов пишется в файл, например в псевдотерминал decoder -p.
+ *
+ *	Последовательность тестов проходится дважды: по очереди и с проверкой
+ *	шины SOut в фоне (TTests::setOverlap()), для второго прохода выводится
+ *	только общее время.
+ *
+ *	Последовательность тестов проходит с задержкой установления шины BusR
+ *	по разрядам (busDelay), измеренное тестом шин данных время сверяется с
+ *	заданным.
+ *
+ *	Для неисправностей разных классов выводится запись ошибок (TFailLog).
+ *
+ *	Проверяется продолжение тестов после сброса МК во время testFram и
+ *	подбор тактов ожидания шины (TTests::sweepBus()). Для TEST_BUS_BENCH
+ *	выводятся такты МК модели и время на ПК на байт для каждого вида
+ *	обращений TBusBench, для TEST_STRESS - замедление прохода FRAM при
+ *	нагрузке на шину из прерывания. Самопроверка при запуске (post())
+ *	проверяется по времени и обнаружению неисправностей, проверка CRC
+ *	программы (checkFlash()) - на образе Debug/TestBSP.hex и образе 64 КБ.
+ *	Планы тестов (setPlan()) выбираются командой по USART1 и проверяются
+ *	по кадрам итераций: выдержка одного теста, последовательность N раз,
+ *	остановка на первой ошибке, продолжение после сброса МК.
+ *
+ *	Затем сравниваются генераторы последовательностей для тестов памяти,
+ *	способы проверки прочитанной памяти (побайтное сравнение и сигнатуры)
+ *	и алгоритмы тестов памяти по обнаружению неисправностей модели.
+ *
+ *	Сборка и запуск описаны в readme.txt.
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../inc/TTests.h"
+#include "../inc/TPattern.h"
+#include "../inc/TSignature.h"
+#include "TFlashImage.h"
+#include "TReportDecoder.h"
+
+/// Период прерывания Timer1 в тактах МК (см. low_level_init()).
+static const uint32_t TICK_CYCLES = TIMER1_PRESCALER * (TIMER1_OCR + 1UL);
+
+/// Запусков самопроверки, за которые проверяется вся FRAM.
+static const unsigned POST_BOOTS = TSimBoard::FLASH_SIZE / TTests::POST_SAMPLES;
+
+static TTests *tests;
+
+/// Блок статистики тестов (в МК размещается в .noinit).
+static TTests::SStatBlock testStat;
+
+// Прерывание Timer1
+static void isrTimer1() {
+	tests->setFlag();
+}
+
+/// Прерывание Timer2 модели платы.
+static void isrTimer2() {
+	tests->Stress.isr();
+}
+
+/**	Сброс платы и настройка периферии, как в low_level_init().
+ *
+ */
+static void initBoard() {
+	simBoard.reset();
+	simBoard.setTimer(TICK_CYCLES, isrTimer1);
+	simBoard.setTimer2Isr(isrTimer2);
+
+	XMCRA = 0x06;
+	MCUCR = (1 << SRE);
+
+	UBRR1H = (UART_UBRR >> 8);
+	UBRR1L = (UART_UBRR & 0xFF);
+	UCSR1A = (1 << U2X1);
+	UCSR1C = (1 << UCSZ11) | (1 << UCSZ10);
+	UCSR1B = (1 << TXEN1) | (1 << RXEN1);
+}
+
+/**	Расшифровка кадров, переданных по USART1 с последнего сброса платы.
+ *
+ *	@param tests Кол-во законченных тестов.
+ *	@return 0 - на каждый тест принят кадр результата, 1 - иначе.
+ */
+static int checkReport(unsigned tests) {
+	const std::vector<uint8_t> &tx = simBoard.getUartTx();
+	TReportDecoder dec;
+	unsigned results = 0;
+
+	for(size_t i = 0; i < tx.size(); i++) {
+		TReportDecoder::SResult res;
+
+		if (dec.put(tx[i]) && dec.getResult(res)) {
+			results++;
+		}
+	}
+
+	printf("%-12s %u bytes, %u frames, %u results, crc errors %u, "
+			"lost %u, %.2f ms\n", "uart", static_cast<unsigned> (tx.size()),
+			dec.getFrames(), results, dec.getCrcErrors(), dec.getLost(),
+			tx.size() * 10.0 * 1000.0 / UART_BAUD_REAL);
+
+	return ((results == tests) && (dec.getCrcErrors() == 0)) ? 0 : 1;
+}
+
+/// Задержка установления шины BusR на модели платы, тактов МК.
+static const uint16_t busDelay[8] = { 16, 16, 16, 16, 24, 24, 32, 48 };
+
+/**	Сверка времени установления шины BusR, измеренного тестом, с моделью.
+ *
+ *	Измеренное время не может быть меньше заданного и больше его на время
+ *	одного опроса BusR.
+ *
+ *	@param t Тесты.
+ *	@return 0 - время совпало с моделью, 1 - иначе.
+ */
+static int checkSettle(const TTests &t) {
+	// опрос BusR с 2 тактами ожидания на шине (XMCRA из low_level_init())
+	static const uint16_t POLL = 12;
+	int result = 0;
+
+	printf("%-12s", "settle");
+	for(uint8_t bit = 0; bit < 8; bit++) {
+		uint16_t time = t.getSettle(bit);
+		bool ok = (time >= busDelay[bit]) && (time <= busDelay[bit] + POLL);
+
+		printf(" %u/%u%s", time, busDelay[bit], ok ? "" : "!");
+		if (!ok) {
+			result = 1;
+		}
+	}
+	printf(" cycles\n");
+
+	return result;
+}
+
+/**	Сверка статистики тестов (TStat) с моделью платы.
+ *
+ *	Обращения к шине, учтенные тестами, должны совпасть с обращениями в
+ *	модели за вычетом сброса сторожевого таймера в каждом вызове main().
+ *
+ *	@param stat Блок статистики тестов.
+ *	@param simBus Обращений к шине в модели для каждого теста.
+ *	@param calls Вызовов main() для каждого теста.
+ *	@return 0 - статистика совпала с моделью, 1 - иначе.
+ */
+static int checkStat(const TTests::SStatBlock *stat,
+		const uint32_t simBus[], const uint32_t calls[]) {
+	int result = 0;
+
+	printf("%-12s %10s %10s %10s %10s %8s\n", "stat", "busy_ms", "wait_ms",
+			"bus", "sim_bus", "runs");
+
+	for(int i = TTests::TEST_SOUT_BUS; i < TTests::TEST_MAX; i++) {
+		const TTests::SStatTest &s = stat->test[i];
+		uint32_t bus = simBus[i] - calls[i];
+
+		printf("%-12s %10.3f %10.1f %10u %10u %8u%s\n", testName[i],
+				s.busy * 1000.0 / F_CPU, s.wait * 1000.0 / F_CPU, s.bus,
+				bus, s.runs, (s.bus == bus) ? "" : " mismatch");
+
+		if (s.bus != bus) {
+			result = 1;
+		}
+	}
+
+	return result;
+}
+
+/**	Проход последовательности тестов FSM.
+ *
+ *	Повторяет цикл main.cpp: шаг тестов, затем спящий режим до следующего
+ *	тика таймера, если работы нет.
+ *
+ *	@param overlap Проверка шины SOut в фоне.
+ *	@return 0 - тесты прошли без ошибок, 1 - иначе.
+ */
+static int benchTests(bool overlap) {
+	int result = 0;
+	unsigned done = 0;
+	uint32_t simBus[TTests::TEST_MAX] = { 0 };
+	uint32_t calls[TTests::TEST_MAX] = { 0 };
+
+	testStat.magic = 0;
+	TTests t(&testStat);
+	tests = &t;
+
+	memcpy(simBoard.busDelay, busDelay, sizeof(busDelay));
+	initBoard();
+	t.setOverlap(overlap);
+	t.Report.sendStart();
+	t.resume(MCUCSR);
+	MCUCSR = 0;
+
+	printf("%-12s %10s %10s %10s %10s %8s %8s %10s\n",
+			overlap ? "overlap" : "test", "mcu_ms", "idle_ms", "bus_rd",
+			"bus_wr", "port", "pgm", "host_us");
+
+	TTests::TESTS cur;
+	do {
+		cur = t.getCurTest();
+		TSimBoard::SStat s = simBoard.getStat();
+		std::chrono::steady_clock::time_point t0 =
+				std::chrono::steady_clock::now();
+
+		do {
+			calls[cur]++;
+			if (t.main())
+				break;
+
+			if (t.isIdle()) {
+				simBoard.sleep();
+			}
+		} while (true);
+		done++;
+
+		std::chrono::steady_clock::time_point t1 =
+				std::chrono::steady_clock::now();
+		const TSimBoard::SStat &e = simBoard.getStat();
+
+		if (!overlap) {
+			printf("%-12s %10.1f %10.1f %10u %10u %8u %8u %10lld\n",
+					testName[cur], (e.cycles - s.cycles) * 1000.0 / F_CPU,
+					(e.idle - s.idle) * 1000.0 / F_CPU,
+					e.busRead - s.busRead, e.busWrite - s.busWrite,
+					e.port - s.port, e.pgm - s.pgm,
+					static_cast<long long> (std::chrono::duration_cast<
+							std::chrono::microseconds>(t1 - t0).count()));
+		}
+		simBus[cur] = (e.busRead - s.busRead) + (e.busWrite - s.busWrite);
+
+		if (t.getError() != 0) {
+			printf("error 0x%02X in %s\n", t.getError(), testName[cur]);
+			result = 1;
+			break;
+		}
+	} while (cur != TTests::TEST_EXT_BUS);
+
+	const TSimBoard::SStat &e = simBoard.getStat();
+	printf("%-12s %10.1f %10.1f %10u %10u %8u %8u\n", "total",
+			e.cycles * 1000.0 / F_CPU, e.idle * 1000.0 / F_CPU,
+			e.busRead, e.busWrite, e.port, e.pgm);
+
+	if (overlap) {
+		return result;
+	}
+
+	result |= checkReport(done);
+	if (result == 0) {
+		result |= checkStat(t.getStat(), simBus, calls);
+		result |= checkSettle(t);
+	}
+	memset(simBoard.busDelay, 0, sizeof(simBoard.busDelay));
+
+	return result;
+}
+
+/**	Замер генератора последовательности.
+ *
+ *	Генерируется объем FRAM, выводится кол-во чтений flash на проход и
+ *	время генерации одного байта на ПК.
+ */
+template <class TPattern>
+static void benchPattern(const char *name) {
+	static const uint16_t SIZE = TSimBoard::FLASH_SIZE;
+	static const int REPEAT = 200;
+	volatile uint16_t sink = 0;
+
+	simBoard.reset();
+	std::chrono::steady_clock::time_point t0 =
+			std::chrono::steady_clock::now();
+
+	for (int r = 0; r < REPEAT; r++) {
+		TPattern gen(r);
+		for (uint16_t i = 0; i < SIZE; i += 2) {
+			sink = gen.next();
+		}
+	}
+
+	std::chrono::steady_clock::time_point t1 =
+			std::chrono::steady_clock::now();
+	double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+	const TSimBoard::SStat &e = simBoard.getStat();
+
+	printf("%-12s %10u %10llu %10.2f\n", name, e.pgm / REPEAT,
+			static_cast<unsigned long long> (e.cycles / REPEAT),
+			ns / REPEAT / SIZE);
+	(void) sink;
+}
+
+/// Запись ошибок последнего runTest().
+static TFailLog lastLog;
+
+/// Обращения к шине за последний runTest().
+static uint32_t lastBus;
+
+/// Алгоритмы тестов памяти.
+static const TTests::MEM_ALG memAlg[] = {
+		TTests::MEM_ALG_PATTERN,
+		TTests::MEM_ALG_MATS_PLUS,
+		TTests::MEM_ALG_MARCH_C,
+		TTests::MEM_ALG_MARCH_B
+};
+
+/// Названия алгоритмов тестов памяти.
+static const char * const memAlgName[] = {
+		"pattern", "mats+", "march_c-", "march_b"
+};
+
+/// Класс неисправностей памяти.
+struct SFaultClass {
+	const char *name;							///< Название.
+	std::vector<TSimBoard::SFault> list;		///< Неисправности.
+};
+
+/**	Однократное выполнение теста на модели платы.
+ *
+ *	Тест останавливается на первом шаге, на котором обнаружена ошибка.
+ *
+ *	@param test Тест.
+ *	@param alg Алгоритм теста памяти.
+ *	@param verify Проверка памяти для MEM_ALG_PATTERN.
+ *	@param fault Неисправность или 0.
+ *	@param[out] cycles Время до окончания теста или обнаружения ошибки,
+ *	тактов МК.
+ *	@return Код ошибки теста.
+ */
+static uint8_t runTest(TTests::TESTS test, TTests::MEM_ALG alg,
+		TTests::MEM_VERIFY verify, const TSimBoard::SFault *fault,
+		uint64_t *cycles) {
+	TTests t(&testStat);
+	tests = &t;
+
+	simBoard.clearFaults();
+	if (fault != 0) {
+		simBoard.addFault(*fault);
+	}
+	initBoard();
+
+	t.setMemAlg(alg);
+	t.setMemVerify(verify);
+	t.setTest(test);
+	while (!t.main() && (t.getError() == 0)) {
+		if (t.isIdle()) {
+			simBoard.sleep();
+		}
+	}
+
+	if (cycles != 0) {
+		*cycles = simBoard.getStat().cycles;
+	}
+	lastLog = t.getFailLog();
+	lastBus = simBoard.getStat().busRead + simBoard.getStat().busWrite;
+
+	return t.getError();
+}
+
+/**	Набор неисправностей области памяти.
+ *
+ *	@param base Начальный адрес области.
+ *	@param size Размер области.
+ *	@param lines Кол-во линий адреса.
+ *	@return Классы неисправностей.
+ */
+static std::vector<SFaultClass> makeFaults(uint16_t base, uint16_t size,
+		uint8_t lines) {
+	std::vector<SFaultClass> cls(5);
+	std::mt19937 rnd(base);
+	TSimBoard::SFault f = TSimBoard::SFault();
+
+	cls[0].name = "stuck-at";
+	for(int i = 0; i < 16; i++) {
+		f.type = TSimBoard::FAULT_STUCK;
+		f.adr = base + rnd() % size;
+		f.mask = 1 << (rnd() % 8);
+		f.val = (i & 1) ? 0xFF : 0x00;
+		cls[0].list.push_back(f);
+	}
+
+	cls[1].name = "data line";
+	for(int i = 0; i < 16; i++) {
+		f.type = TSimBoard::FAULT_DATA;
+		f.adr = base;
+		f.mask = 1 << (i % 8);
+		f.val = (i < 8) ? 0xFF : 0x00;
+		cls[1].list.push_back(f);
+	}
+
+	cls[2].name = "coupling";
+	for(int i = 0; i < 16; i++) {
+		f.type = TSimBoard::FAULT_COUPLING;
+		f.adr = base + rnd() % size;
+		do {
+			f.adr2 = base + rnd() % size;
+		} while (f.adr2 == f.adr);
+		f.mask = 1 << (rnd() % 8);
+		cls[2].list.push_back(f);
+	}
+
+	cls[3].name = "adr stuck";
+	for(uint8_t i = 0; i < 2 * lines; i++) {
+		f.type = TSimBoard::FAULT_ADR_STUCK;
+		f.adr = base;
+		f.line = i / 2;
+		f.val = i & 1;
+		cls[3].list.push_back(f);
+	}
+
+	cls[4].name = "adr short";
+	for(uint8_t i = 0; i + 1 < lines; i++) {
+		f.type = TSimBoard::FAULT_ADR_SHORT;
+		f.adr = base;
+		f.line = i;
+		f.line2 = i + 1;
+		cls[4].list.push_back(f);
+	}
+
+	return cls;
+}
+
+/**	Набор неисправностей регистров ПЛИС и шин BusW/BusR.
+ *
+ *	@return Классы неисправностей.
+ */
+static std::vector<SFaultClass> makePlisFaults() {
+	// регистры записи/чтения ПЛИС
+	static const uint8_t reg[] = {
+			TSimBoard::PLIS_INIT, TSimBoard::PLIS_DD_L, TSimBoard::PLIS_DD_H,
+			TSimBoard::PLIS_CUR_ADR, TSimBoard::PLIS_EXT_SET,
+			TSimBoard::PLIS_BUS_W, TSimBoard::PLIS_BANK_FL
+	};
+	static const uint8_t REGS = sizeof(reg) / sizeof(reg[0]);
+	std::vector<SFaultClass> cls(4);
+	TSimBoard::SFault f = TSimBoard::SFault();
+
+	// 16 регистров - 4 линии адреса
+	cls[0].name = "plis adr";
+	for(uint8_t i = 0; i < 2 * 4; i++) {
+		f.type = TSimBoard::FAULT_ADR_STUCK;
+		f.adr = TSimBoard::PLIS_ADR;
+		f.line = i / 2;
+		f.val = i & 1;
+		cls[0].list.push_back(f);
+	}
+	for(uint8_t i = 0; i + 1 < 4; i++) {
+		f.type = TSimBoard::FAULT_ADR_SHORT;
+		f.adr = TSimBoard::PLIS_ADR;
+		f.line = i;
+		f.line2 = i + 1;
+		cls[0].list.push_back(f);
+	}
+
+	cls[1].name = "plis alias";
+	for(uint8_t i = 0; i < REGS; i++) {
+		f.type = TSimBoard::FAULT_ALIAS;
+		f.adr = TSimBoard::PLIS_ADR + reg[i];
+		f.adr2 = TSimBoard::PLIS_ADR + reg[(i + 1) % REGS];
+		cls[1].list.push_back(f);
+		f.adr = TSimBoard::PLIS_ADR + reg[(i + 1) % REGS];
+		f.adr2 = TSimBoard::PLIS_ADR + reg[i];
+		cls[1].list.push_back(f);
+	}
+
+	cls[2].name = "busR stuck";
+	for(uint8_t i = 0; i < 16; i++) {
+		f.type = TSimBoard::FAULT_STUCK;
+		f.adr = TSimBoard::PLIS_ADR + TSimBoard::PLIS_BUS_R;
+		f.mask = 1 << (i % 8);
+		f.val = (i < 8) ? 0xFF : 0x00;
+		cls[2].list.push_back(f);
+	}
+
+	cls[3].name = "busR map";
+	for(uint8_t i = 0; i < 8; i++) {
+		f.type = TSimBoard::FAULT_BUS_MAP;
+		f.line = i;
+		f.line2 = (i + 1 + i / 4) % 8;
+		cls[3].list.push_back(f);
+	}
+
+	return cls;
+}
+
+/// Тесты для сравнения по обнаружению неисправностей.
+static const TTests::TESTS detectTest[] = {
+		TTests::TEST_PLIS_REG,
+		TTests::TEST_DATA_BUS,
+		TTests::TEST_FRAM,
+		TTests::TEST_2RAM
+};
+
+/// Названия тестов для сравнения по обнаружению неисправностей.
+static const char * const detectTestName[] = {
+		"plis_reg", "data_bus", "fram", "2ram"
+};
+
+/// Кол-во тестов для сравнения по обнаружению неисправностей.
+static const int DETECT_NUM = sizeof(detectTest) / sizeof(detectTest[0]);
+
+/**	Обнаружение неисправностей тестами и время до обнаружения.
+ *
+ *	Каждый тест запускается отдельно (setTest()) для каждой неисправности
+ *	и останавливается на шаге, на котором обнаружена ошибка. Для каждого
+ *	класса неисправностей и теста выводится обнаружено/всего, среднее
+ *	кол-во обращений к шине и тиков Timer1 до обнаружения. В последнем
+ *	столбце - тест, обнаруживший больше всех неисправностей класса, а из
+ *	них - быстрее всех. В строке "pass" - обращения к шине и тики теста
+ *	без неисправностей.
+ */
+static void benchDetect() {
+	std::vector<SFaultClass> cls;
+	static const char * const areaName[] = { "FRAM", "2RAM" };
+	static const uint16_t areaAdr[] = {
+			TSimBoard::FLASH_ADR, TSimBoard::RAM_ADR
+	};
+	static const uint16_t areaSize[] = {
+			TSimBoard::FLASH_SIZE, TSimBoard::RAM_SIZE
+	};
+	static const uint8_t areaLines[] = { 15, 11 };
+	std::vector<std::string> clsName;
+
+	for(int a = 0; a < 2; a++) {
+		std::vector<SFaultClass> mem = makeFaults(areaAdr[a], areaSize[a],
+				areaLines[a]);
+		for(size_t c = 0; c < mem.size(); c++) {
+			cls.push_back(mem[c]);
+			clsName.push_back(std::string(areaName[a]) + " " + mem[c].name);
+		}
+	}
+	std::vector<SFaultClass> plis = makePlisFaults();
+	for(size_t c = 0; c < plis.size(); c++) {
+		cls.push_back(plis[c]);
+		clsName.push_back(plis[c].name);
+	}
+
+	printf("\n%-15s", "detect");
+	for(int t = 0; t < DETECT_NUM; t++) {
+		printf(" %20s", detectTestName[t]);
+	}
+	printf("  %s\n", "first");
+
+	printf("%-15s", "pass");
+	for(int t = 0; t < DETECT_NUM; t++) {
+		uint64_t cycles = 0;
+		runTest(detectTest[t], TTests::MEM_ALG_DEFAULT,
+				TTests::MEM_VERIFY_DEFAULT, 0, &cycles);
+		printf(" %8s %6u %5u", "", lastBus,
+				static_cast<unsigned> (cycles / TICK_CYCLES));
+	}
+	printf("\n");
+
+	// обнаружено/всего, обращений к шине и тиков до обнаружения
+	for(size_t c = 0; c < cls.size(); c++) {
+		int first = -1;
+		unsigned firstDetected = 0;
+		uint64_t firstCycles = 0;
+
+		printf("%-15s", clsName[c].c_str());
+		for(int t = 0; t < DETECT_NUM; t++) {
+			unsigned detected = 0;
+			uint64_t bus = 0;
+			uint64_t reject = 0;
+
+			for(size_t i = 0; i < cls[c].list.size(); i++) {
+				uint64_t cycles = 0;
+				if (runTest(detectTest[t], TTests::MEM_ALG_DEFAULT,
+						TTests::MEM_VERIFY_DEFAULT, &cls[c].list[i],
+						&cycles) != 0) {
+					detected++;
+					bus += lastBus;
+					reject += cycles;
+				}
+			}
+
+			if (detected == 0) {
+				printf(" %3u/%-3u %6s %5s", 0U,
+						static_cast<unsigned> (cls[c].list.size()), "-", "-");
+				continue;
+			}
+			printf(" %3u/%-3u %6u %5u", detected,
+					static_cast<unsigned> (cls[c].list.size()),
+					static_cast<unsigned> (bus / detected),
+					static_cast<unsigned> (reject / detected / TICK_CYCLES));
+
+			// среднее время сравнивается без деления: reject / detected
+			if ((detected > firstDetected) || ((detected == firstDetected) &&
+					(reject * firstDetected < firstCycles * detected))) {
+				first = t;
+				firstDetected = detected;
+				firstCycles = reject;
+			}
+		}
+		printf("  %s\n", (first >= 0) ? detectTestName[first] : "-");
+	}
+	simBoard.clearFaults();
+}
+
+/**	Сравнение алгоритмов теста памяти по обнаружению неисправностей.
+ *
+ *	@param name Название области памяти.
+ *	@param test Тест области памяти.
+ *	@param base Начальный адрес области.
+ *	@param size Размер области.
+ *	@param lines Кол-во линий адреса.
+ */
+static void benchCoverage(const char *name, TTests::TESTS test,
+		uint16_t base, uint16_t size, uint8_t lines) {
+	static const int ALG_NUM = sizeof(memAlg) / sizeof(memAlg[0]);
+	std::vector<SFaultClass> cls = makeFaults(base, size, lines);
+
+	printf("\n%-12s", name);
+	for(int a = 0; a < ALG_NUM; a++) {
+		printf(" %18s", memAlgName[a]);
+	}
+	printf("\n");
+
+	// обнаружено/всего и среднее время до обнаружения, мс
+	for(size_t c = 0; c < cls.size(); c++) {
+		printf("%-12s", cls[c].name);
+		for(int a = 0; a < ALG_NUM; a++) {
+			unsigned detected = 0;
+			uint64_t reject = 0;
+			for(size_t i = 0; i < cls[c].list.size(); i++) {
+				uint64_t cycles = 0;
+				if (runTest(test, memAlg[a], TTests::MEM_VERIFY_COMPARE,
+						&cls[c].list[i], &cycles) != 0) {
+					detected++;
+					reject += cycles;
+				}
+			}
+			printf(" %3u/%-3u %10.3f", detected,
+					static_cast<unsigned> (cls[c].list.size()),
+					detected ? reject * 1000.0 / F_CPU / detected : 0.0);
+		}
+		printf("\n");
+	}
+
+	printf("%-12s", "mcu_ms");
+	for(int a = 0; a < ALG_NUM; a++) {
+		uint64_t cycles = 0;
+		runTest(test, memAlg[a], TTests::MEM_VERIFY_COMPARE, 0, &cycles);
+		printf(" %18.1f", cycles * 1000.0 / F_CPU);
+	}
+	printf("\n");
+	simBoard.clearFaults();
+}
+
+/**	Запись ошибок теста памяти для неисправностей разных классов.
+ *
+ *	Для первой неисправности каждого класса выводится кол-во ошибок, общая
+ *	маска разрядов и первые записи.
+ *
+ *	@param name Название области памяти.
+ *	@param test Тест области памяти.
+ *	@param base Начальный адрес области.
+ *	@param size Размер области.
+ *	@param lines Кол-во линий адреса.
+ */
+static void benchFailLog(const char *name, TTests::TESTS test,
+		uint16_t base, uint16_t size, uint8_t lines) {
+	std::vector<SFaultClass> cls = makeFaults(base, size, lines);
+
+	printf("\n%-12s %-10s %6s %6s %6s %5s  %s\n", name, "fault", "error",
+			"fails", "lost", "mask", "runs");
+	for(size_t c = 0; c < cls.size(); c++) {
+		uint8_t error = runTest(test, TTests::MEM_ALG_MARCH_C,
+				TTests::MEM_VERIFY_COMPARE, &cls[c].list[0], 0);
+
+		printf("%-12s %-10.10s   0x%02X %6u %6u  0x%02X  %u:", "",
+				cls[c].name, error, lastLog.getFails(), lastLog.getLost(),
+				lastLog.getMask(), lastLog.getNum());
+		for(uint8_t i = 0; (i < lastLog.getNum()) && (i < 3); i++) {
+			const TFailLog::SRun &r = lastLog.getRun(i);
+			printf(" 0x%04X+%u:0x%02X", r.adr, r.len, r.mask);
+		}
+		printf("\n");
+	}
+	simBoard.clearFaults();
+}
+
+/**	Замер чтения области FRAM с проверкой по сигнатуре.
+ *
+ *	Выводится кол-во обращений к шине и чтений flash на байт, время МК на
+ *	байт (без учета арифметики) и время на ПК.
+ */
+template <class TSig>
+static void benchSignature(const char *name) {
+	static const uint16_t SIZE = TSimBoard::FLASH_SIZE;
+	volatile EXT_REG(uint8_t) *p =
+			extPtr<EXT_REG(uint8_t)> (TSimBoard::FLASH_ADR);
+	volatile uint32_t sink = 0;
+
+	simBoard.reset();
+	simBoard.write(TSimBoard::PLIS_ADR + TSimBoard::PLIS_INIT, 0x55);
+
+	// память исправной платы, записанная без учета времени
+	TPatternXorshift wr(0);
+	for (uint16_t i = 0; i < SIZE; i += 2) {
+		uint16_t val = wr.next();
+		simBoard.space[TSimBoard::FLASH_ADR + i] = val;
+		simBoard.space[TSimBoard::FLASH_ADR + i + 1] = val >> 8;
+	}
+
+	TSimBoard::SStat s = simBoard.getStat();
+	std::chrono::steady_clock::time_point t0 =
+			std::chrono::steady_clock::now();
+
+	if (TSig::ENABLED) {
+		TSig sig;
+		for (uint16_t i = 0; i < SIZE; i++) {
+			sig.add(p[i]);
+		}
+		sink = sig.get();
+	} else {
+		// побайтное сравнение с последовательностью
+		TPatternXorshift rd(0);
+		for (uint16_t i = 0; i < SIZE; i += 2) {
+			uint16_t val = rd.next();
+			if ((p[i] != (uint8_t) val) || (p[i + 1] != (uint8_t) (val >> 8)))
+				sink++;
+		}
+	}
+
+	std::chrono::steady_clock::time_point t1 =
+			std::chrono::steady_clock::now();
+	const TSimBoard::SStat &e = simBoard.getStat();
+	double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+
+	printf("%-12s %10.2f %10.2f %10.2f %10.2f\n", name,
+			(e.busRead - s.busRead) / double(SIZE),
+			(e.pgm - s.pgm) / double(SIZE),
+			(e.cycles - s.cycles) / double(SIZE), ns / SIZE);
+	(void) sink;
+}
+
+/**	Сравнение побайтной проверки памяти и проверки по сигнатуре.
+ *
+ *	Для алгоритма MEM_ALG_PATTERN выводится время теста на исправной
+ *	плате, кол-во чтений flash и обнаружение неисправностей.
+ *
+ *	@param name Название области памяти.
+ *	@param test Тест области памяти.
+ *	@param base Начальный адрес области.
+ *	@param size Размер области.
+ *	@param lines Кол-во линий адреса.
+ */
+static void benchVerify(const char *name, TTests::TESTS test,
+		uint16_t base, uint16_t size, uint8_t lines) {
+	static const TTests::MEM_VERIFY verify[] = {
+			TTests::MEM_VERIFY_COMPARE, TTests::MEM_VERIFY_SIGNATURE
+	};
+	static const char * const verifyName[] = { "compare", "signature" };
+	std::vector<SFaultClass> cls = makeFaults(base, size, lines);
+
+	printf("\n%-12s %10s %10s %10s", name, "mcu_ms", "bus_rd", "pgm");
+	for(size_t c = 0; c < cls.size(); c++) {
+		printf(" %10.10s", cls[c].name);
+	}
+	printf("\n");
+
+	for(int v = 0; v < 2; v++) {
+		uint64_t cycles = 0;
+
+		runTest(test, TTests::MEM_ALG_PATTERN, verify[v], 0, &cycles);
+		const TSimBoard::SStat &e = simBoard.getStat();
+		printf("%-12s %10.1f %10u %10u", verifyName[v],
+				cycles * 1000.0 / F_CPU, e.busRead, e.pgm);
+
+		for(size_t c = 0; c < cls.size(); c++) {
+			unsigned detected = 0;
+			for(size_t i = 0; i < cls[c].list.size(); i++) {
+				if (runTest(test, TTests::MEM_ALG_PATTERN, verify[v],
+						&cls[c].list[i], 0) != 0) {
+					detected++;
+				}
+			}
+			printf("    %3u/%-3u", detected,
+					static_cast<unsigned> (cls[c].list.size()));
+		}
+		printf("\n");
+	}
+	simBoard.clearFaults();
+}
+
+/**	Обнаружение разряда BusR, не установившегося за DATA_BUS_TIMEOUT_US.
+ *
+ *	@return 0 - тест шин данных обнаружил ошибку, 1 - иначе.
+ */
+static int benchSettleTimeout() {
+	uint64_t cycles = 0;
+
+	simBoard.busDelay[5] = US_TO_CYCLES(DATA_BUS_TIMEOUT_US) + 1;
+	uint8_t error = runTest(TTests::TEST_DATA_BUS, TTests::MEM_ALG_DEFAULT,
+			TTests::MEM_VERIFY_DEFAULT, 0, &cycles);
+	simBoard.busDelay[5] = 0;
+
+	printf("%-12s error=0x%02X, %.3f ms\n", "settle fail", error,
+			cycles * 1000.0 / F_CPU);
+
+	return (error & (1 << 1)) ? 0 : 1;
+}
+
+/**	Продолжение тестов после сброса МК.
+ *
+ *	testFram прерывается после двух шагов. МК сбрасывается так, что
+ *	память и блок статистики сохраняются. После сброса внешним сторожевым
+ *	таймером тесты должны продолжиться с testFram, а после включения
+ *	питания - начаться с testSoutBus.
+ *
+ *	@return 0 - тесты продолжены верно, 1 - иначе.
+ */
+static int benchResume() {
+	static const uint8_t cause[] = { (1 << EXTRF), (1 << PORF) };
+	static const TTests::TESTS expect[] = {
+			TTests::TEST_FRAM, TTests::TEST_SOUT_BUS
+	};
+	int result = 0;
+
+	for(int i = 0; i < 2; i++) {
+		testStat.magic = 0;
+		initBoard();
+
+		TTests t(&testStat);
+		tests = &t;
+		t.resume(MCUCSR);
+		MCUCSR = 0;
+		t.setTest(TTests::TEST_FRAM);
+		while (testStat.check.step < 2) {
+			t.main();
+			if (t.isIdle()) {
+				simBoard.sleep();
+			}
+		}
+
+		// сброс МК: внешняя память и .noinit сохраняются
+		MCUCSR = cause[i];
+		TTests r(&testStat);
+		tests = &r;
+		r.resume(MCUCSR);
+		MCUCSR = 0;
+
+		TReportDecoder dec;
+		const std::vector<uint8_t> &tx = simBoard.getUartTx();
+		for(size_t j = 0; j < tx.size(); j++) {
+			if (dec.put(tx[j]) && (dec.getFrame().type ==
+					TReport::TYPE_RESET)) {
+				dec.print(stdout);
+			}
+		}
+
+		if (r.getCurTest() != expect[i]) {
+			printf("resume to %s, expected %s\n", testName[r.getCurTest()],
+					testName[expect[i]]);
+			result = 1;
+		}
+	}
+
+	return result;
+}
+
+/**	Зависание теста после продолжения.
+ *
+ *	testFram каждый раз прерывается сбросом внешним сторожевым таймером
+ *	после двух шагов. Тест должен продолжиться TTests::RESUME_MAX раз, а
+ *	после следующего сброса - закончиться ошибкой TTests::RESUME_ERROR с
+ *	переходом к testError.
+ *
+ *	@return 0 - продолжения ограничены верно, 1 - иначе.
+ */
+static int benchResumeHang() {
+	int result = 0;
+
+	testStat.magic = 0;
+	initBoard();
+	TTests t(&testStat);
+	tests = &t;
+	t.resume(MCUCSR);
+	MCUCSR = 0;
+	t.setTest(TTests::TEST_FRAM);
+
+	TTests *cur = &t;
+	for(uint8_t k = 0; k <= TTests::RESUME_MAX; k++) {
+		while (testStat.check.step < 2) {
+			cur->main();
+			if (cur->isIdle()) {
+				simBoard.sleep();
+			}
+		}
+
+		// сброс МК: внешняя память и .noinit сохраняются
+		MCUCSR = (1 << WDRF);
+		TTests *r = new TTests(&testStat);
+		tests = r;
+		r->resume(MCUCSR);
+		MCUCSR = 0;
+		if (cur != &t) {
+			delete cur;
+		}
+		cur = r;
+
+		TTests::TESTS expect = (k < TTests::RESUME_MAX) ?
+				TTests::TEST_FRAM : TTests::TEST_ERROR;
+		if (cur->getCurTest() != expect) {
+			printf("reset %u: resume to %s, expected %s\n", k + 1,
+					testName[cur->getCurTest()], testName[expect]);
+			result = 1;
+		}
+	}
+
+	printf("%-12s %u resumes, then %s error=0x%02X\n", "resume hang",
+			TTests::RESUME_MAX, testName[cur->getCurTest()],
+			cur->getError());
+	if (cur->getError() != TTests::RESUME_ERROR) {
+		result = 1;
+	}
+	delete cur;
+	tests = 0;
+
+	return result;
+}
+
+/**	Подбор тактов ожидания внешней шины.
+ *
+ *	Для областей задается минимальная длительность строба, при более
+ *	коротком модель искажает обращения. Маски прошедших настроек должны
+ *	совпасть с рассчитанными по длительности строба.
+ *
+ *	@return 0 - результат подбора верный, 1 - иначе.
+ */
+static int benchSweep() {
+	// TTests::BUS_AREA -> область модели и минимальный строб, нс
+	static const TSimBoard::AREA area[TTests::BUS_AREA_MAX] = {
+			TSimBoard::AREA_RAM, TSimBoard::AREA_FRAM, TSimBoard::AREA_PLIS
+	};
+	static const uint16_t ns[TTests::BUS_AREA_MAX] = { 70, 150, 110 };
+	// длительность строба в тактах для SRW11:SRW10
+	static const uint8_t strobe[TTests::BUS_WAIT_MAX] = { 1, 2, 3, 3 };
+	int result = 0;
+
+	testStat.magic = 0;
+	initBoard();
+	for(uint8_t a = 0; a < TTests::BUS_AREA_MAX; a++) {
+		simBoard.accessNs[area[a]] = ns[a];
+	}
+
+	TTests t(&testStat);
+	tests = &t;
+	uint64_t start = simBoard.getStat().cycles;
+	t.sweepBus();
+	uint64_t cycles = simBoard.getStat().cycles - start;
+
+	for(uint8_t a = 0; a < TTests::BUS_AREA_MAX; a++) {
+		simBoard.accessNs[area[a]] = 0;
+	}
+
+	TReportDecoder dec;
+	const std::vector<uint8_t> &tx = simBoard.getUartTx();
+	for(size_t j = 0; j < tx.size(); j++) {
+		if (dec.put(tx[j]) && (dec.getFrame().type == TReport::TYPE_SWEEP)) {
+			dec.print(stdout);
+		}
+	}
+	printf("%-12s %.3f ms\n", "sweep", cycles * 1000.0 / F_CPU);
+
+	for(uint8_t a = 0; a < TTests::BUS_AREA_MAX; a++) {
+		for(uint8_t d = 0; d < TTests::BUS_DIV_MAX; d++) {
+			uint8_t expect = 0;
+
+			for(uint8_t w = 0; w < TTests::BUS_WAIT_MAX; w++) {
+				uint64_t strobeNs = strobe[w] * TTests::getSweepDiv(d) *
+						1000000000ULL / F_CPU;
+
+				if (strobeNs >= ns[a]) {
+					expect |= (1 << w);
+				}
+			}
+
+			if (t.getSweep(static_cast<TTests::BUS_AREA> (a), d) != expect) {
+				printf("sweep %s /%u: 0x%X, expected 0x%X\n", busAreaName[a],
+						TTests::getSweepDiv(d),
+						t.getSweep(static_cast<TTests::BUS_AREA> (a), d),
+						expect);
+				result = 1;
+			}
+		}
+	}
+
+	if ((XMCRA != 0x06) || (MCUCR != (1 << SRE)) || (XDIV != 0)) {
+		printf("sweep: bus settings not restored\n");
+		result = 1;
+	}
+
+	return result;
+}
+
+/**	Время одного обращения TBusBench на ПК.
+ *
+ *	Модель считает только такты обращений к шине, поэтому разница между
+ *	циклами видна по времени на ПК.
+ *
+ *	@param area Область шины (TTests::BUS_AREA).
+ *	@param kind Вид обращений.
+ *	@return Время на байт, нс.
+ */
+static double hostBusBench(uint8_t area, uint8_t kind) {
+	static const int REPEAT = 16;
+	std::chrono::steady_clock::time_point t0 =
+			std::chrono::steady_clock::now();
+
+	for(int i = 0; i < REPEAT; i++) {
+		switch(area) {
+			case TTests::BUS_AREA_2RAM:
+				TBusBench::run<TSimBoard::RAM_ADR,
+						TSimBoard::RAM_SIZE - 1> (kind);
+				break;
+			case TTests::BUS_AREA_FRAM:
+				TBusBench::run<TSimBoard::FLASH_ADR,
+						TSimBoard::FLASH_SIZE - 1> (kind);
+				break;
+			default:
+				TBusBench::run<TSimBoard::PLIS_ADR +
+						TSimBoard::PLIS_CUR_ADR, 0> (kind);
+				break;
+		}
+	}
+
+	std::chrono::steady_clock::time_point t1 =
+			std::chrono::steady_clock::now();
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			t1 - t0).count() / static_cast<double> (REPEAT * TBusBench::BYTES);
+}
+
+/**	Замер пропускной способности внешней шины (TEST_BUS_BENCH).
+ *
+ *	Результаты берутся из кадров TReport::TYPE_BENCH, как на стенде.
+ *	Выводятся такты МК на байт и КБ/с для цикла по байту и развернутого.
+ *
+ *	@return 0 - кадры замеров приняты и обращения к шине учтены верно,
+ *	1 - иначе.
+ */
+static int benchBusBench() {
+	static const char * const opName[TBusBench::OP_MAX] = {
+			"read", "write", "rmw"
+	};
+	static const char * const orderName[TBusBench::ORDER_MAX] = {
+			"seq", "rand"
+	};
+	int result = 0;
+	unsigned frames = 0;
+
+	testStat.magic = 0;
+	initBoard();
+	TTests t(&testStat);
+	tests = &t;
+	t.Report.sendStart();
+	t.setTest(TTests::TEST_BUS_BENCH);
+
+	TSimBoard::SStat s = simBoard.getStat();
+	uint32_t calls = 0;
+	std::chrono::steady_clock::time_point t0 =
+			std::chrono::steady_clock::now();
+	do {
+		calls++;
+		if (t.main())
+			break;
+		if (t.isIdle()) {
+			simBoard.sleep();
+		}
+	} while (true);
+	std::chrono::steady_clock::time_point t1 =
+			std::chrono::steady_clock::now();
+	// копия: замеры на ПК ниже продвигают время модели
+	const TSimBoard::SStat e = simBoard.getStat();
+	uint32_t bus = (e.busRead - s.busRead) + (e.busWrite - s.busWrite) - calls;
+
+	printf("\n%-12s %-6s %-6s %8s %8s %8s %8s %8s %8s\n", "bus bench", "op",
+			"order", "cyc/b", "kb/s", "host_ns", "cyc/b u8", "kb/s u8",
+			"host_ns");
+
+	TReportDecoder dec;
+	const std::vector<uint8_t> &tx = simBoard.getUartTx();
+	for(size_t j = 0; j < tx.size(); j++) {
+		TReportDecoder::SBench bn;
+
+		if (!dec.put(tx[j]) || !dec.getBench(bn))
+			continue;
+
+		frames++;
+		for(uint8_t op = 0; op < TBusBench::OP_MAX; op++) {
+			for(uint8_t ord = 0; ord < TBusBench::ORDER_MAX; ord++) {
+				uint8_t k = TBusBench::getKind(static_cast<TBusBench::OP> (op),
+						static_cast<TBusBench::ORDER> (ord),
+						TBusBench::LOOP_BYTE);
+
+				printf("%-12s %-6s %-6s %8.2f %8.0f %8.2f %8.2f %8.0f %8.2f\n",
+						(op == 0 && ord == 0) ? busAreaName[bn.area] : "",
+						opName[op], orderName[ord],
+						bn.cycles[k] / static_cast<double> (bn.bytes),
+						dec.getBytesPerSec(bn, k) / 1024,
+						hostBusBench(bn.area, k),
+						bn.cycles[k + 1] / static_cast<double> (bn.bytes),
+						dec.getBytesPerSec(bn, k + 1) / 1024,
+						hostBusBench(bn.area, k + 1));
+			}
+		}
+	}
+
+	const TTests::SStatTest &st = t.getStat()->test[TTests::TEST_BUS_BENCH];
+	printf("%-12s %u frames, bus %u/%u, %.1f ms, host %lld us\n", "", frames,
+			st.bus, bus, (e.cycles - s.cycles) * 1000.0 / F_CPU,
+			static_cast<long long> (std::chrono::duration_cast<
+					std::chrono::microseconds>(t1 - t0).count()));
+
+	if ((frames != TTests::BUS_AREA_MAX) || (st.bus != bus)) {
+		result = 1;
+	}
+
+	return result;
+}
+
+/**	Проверка FRAM при нагрузке на шину из прерывания (TEST_STRESS).
+ *
+ *	Выводится кадр TReport::TYPE_STRESS. Обращения к шине в модели должны
+ *	совпасть с учтенными тестом и обращениями в прерываниях.
+ *
+ *	@return 0 - ошибок нет, прерывания были и обращения учтены верно,
+ *	1 - иначе.
+ */
+static int benchStress() {
+	TReportDecoder::SStress ss = TReportDecoder::SStress();
+	bool received = false;
+	uint32_t calls = 0;
+
+	testStat.magic = 0;
+	initBoard();
+	TTests t(&testStat);
+	tests = &t;
+	t.Report.sendStart();
+	t.setTest(TTests::TEST_STRESS);
+
+	TSimBoard::SStat s = simBoard.getStat();
+	do {
+		calls++;
+		if (t.main())
+			break;
+		if (t.isIdle()) {
+			simBoard.sleep();
+		}
+	} while (true);
+	const TSimBoard::SStat &e = simBoard.getStat();
+	uint32_t bus = (e.busRead - s.busRead) + (e.busWrite - s.busWrite) - calls;
+
+	printf("\n");
+	TReportDecoder dec;
+	const std::vector<uint8_t> &tx = simBoard.getUartTx();
+	for(size_t j = 0; j < tx.size(); j++) {
+		if (dec.put(tx[j]) && dec.getStress(ss)) {
+			dec.print(stdout);
+			received = true;
+		}
+	}
+
+	const TTests::SStatTest &st = t.getStat()->test[TTests::TEST_STRESS];
+	uint32_t isrBus = ss.calls * TBusStress::BUS_PER_CALL;
+	printf("%-12s error=0x%02X, bus %u + isr %u / %u\n", "stress",
+			t.getError(), st.bus, isrBus, bus);
+
+	return (received && (t.getError() == 0) && (ss.calls != 0) &&
+			(st.bus + isrBus == bus)) ? 0 : 1;
+}
+
+/**	Длительность последовательности SOut.
+ *
+ *	@param p Последовательность.
+ *	@return Тиков таймера.
+ */
+static uint32_t getSeqTicks(const TSoutSeq::SStep *p) {
+	uint32_t ticks = 0;
+
+	for(; p->op != TSoutSeq::OP_END; p++) {
+		ticks += p->ticks;
+	}
+
+	return ticks;
+}
+
+/**	Вывод кода ошибки проверки FRAM при нагрузке.
+ *
+ *	С неисправностью FRAM TEST_STRESS заканчивается ошибкой, код ошибки
+ *	должен быть выведен на SOut ровно один раз: время до начала
+ *	TEST_PLIS_REG - TSoutSeq::ERROR_CODE и TSoutSeq::WALK теста
+ *	TEST_SOUT_BUS.
+ *
+ *	@return 0 - код выведен один раз, 1 - иначе.
+ */
+static int benchStressError() {
+	TSimBoard::SFault f = TSimBoard::SFault();
+	f.type = TSimBoard::FAULT_STUCK;
+	f.adr = TSimBoard::FLASH_ADR + 0x1234;
+	f.mask = 0x10;
+	f.val = 0xFF;
+
+	testStat.magic = 0;
+	simBoard.clearFaults();
+	simBoard.addFault(f);
+	initBoard();
+	TTests t(&testStat);
+	tests = &t;
+	t.setTest(TTests::TEST_STRESS);
+
+	while (!t.main()) {
+		if (t.isIdle()) {
+			simBoard.sleep();
+		}
+	}
+	uint8_t error = t.getError();
+	uint64_t start = simBoard.getStat().cycles;
+
+	while (t.getCurTest() != TTests::TEST_PLIS_REG) {
+		t.main();
+		if (t.isIdle()) {
+			simBoard.sleep();
+		}
+	}
+	simBoard.clearFaults();
+
+	uint32_t ticks = (simBoard.getStat().cycles - start) / TICK_CYCLES;
+	uint32_t code = getSeqTicks(TSoutSeq::ERROR_CODE);
+	uint32_t walk = getSeqTicks(TSoutSeq::WALK);
+	unsigned shown = (ticks > walk) ? (ticks - walk + code / 2) / code : 0;
+	printf("%-12s error=0x%02X, code shown %u time(s), %u ticks\n",
+			"stress err", error, shown, static_cast<unsigned> (ticks));
+
+	return ((error != 0) && (shown == 1)) ? 0 : 1;
+}
+
+/**	Однократная самопроверка (TTests::post()) на модели платы.
+ *
+ *	FRAM модели при сбросе очищается, поэтому счетчик запусков
+ *	самопроверки в последней ячейке FRAM задается перед проверкой.
+ *
+ *	@param fault Неисправность или 0.
+ *	@param[out] bus Обращения к шине, учтенные самопроверкой (TStat).
+ *	@param boot Счетчик запусков самопроверки.
+ *	@return Код ошибки самопроверки.
+ */
+static uint8_t runPost(const TSimBoard::SFault *fault, uint32_t *bus,
+		uint8_t boot = 0) {
+	testStat.magic = 0;
+	TTests t(&testStat);
+	tests = &t;
+
+	simBoard.clearFaults();
+	if (fault != 0) {
+		simBoard.addFault(*fault);
+	}
+	initBoard();
+	if (boot != 0) {
+		// FRAM модели доступна только после записи 0x55 в Init ПЛИС
+		simBoard.write(TSimBoard::PLIS_ADR + TSimBoard::PLIS_INIT, 0x55);
+		simBoard.write(TSimBoard::FLASH_ADR + TSimBoard::FLASH_SIZE - 1, boot);
+		simBoard.write(TSimBoard::PLIS_ADR + TSimBoard::PLIS_INIT, 0x00);
+	}
+
+	uint32_t start = TStat::getBus();
+	uint8_t error = t.post();
+	if (bus != 0) {
+		*bus = TStat::getBus() - start;
+	}
+
+	return error;
+}
+
+/**	Быстрая самопроверка при запуске.
+ *
+ *	Самопроверка исправной платы должна пройти не дольше POST_TIME_MS (с
+ *	оценкой вычислений МК) с POST_SOUT_PASS на SOut, кадр TReport::TYPE_POST - совпасть с моделью.
+ *	Для классов неисправностей FRAM, 2RAM и ПЛИС выводится кол-во
+ *	обнаруженных самопроверкой (с POST_SOUT_FAIL на SOut) при первом
+ *	запуске, для FRAM - еще и хотя бы на одном из POST_BOOTS запусков
+ *	подряд (выборка FRAM сдвигается на каждом запуске).
+ *
+ *	@return 0 - самопроверка прошла, 1 - иначе.
+ */
+static int benchPost() {
+	TReportDecoder::SPost ps = TReportDecoder::SPost();
+	bool received = false;
+	uint32_t bus = 0;
+
+	uint8_t error = runPost(0, &bus);
+	const TSimBoard::SStat &e = simBoard.getStat();
+	uint32_t simBus = e.busRead + e.busWrite;
+	uint8_t sout = simBoard.getSout();
+
+	printf("\n");
+	TReportDecoder dec;
+	const std::vector<uint8_t> &tx = simBoard.getUartTx();
+	for(size_t j = 0; j < tx.size(); j++) {
+		if (dec.put(tx[j]) && dec.getPost(ps)) {
+			dec.print(stdout);
+			received = true;
+		}
+	}
+	// модель не учитывает вычисления, оценка с запасом - по
+	// MEM_CYCLES_PER_BYTE (байт теста памяти) на каждое обращение к шине
+	uint64_t est = e.cycles + static_cast<uint64_t> (simBus) *
+			MEM_CYCLES_PER_BYTE;
+	printf("%-12s error=0x%02X, %.1f ms, est %.1f ms (max %u), "
+			"bus %u / %u, sout 0x%02X\n", "post", error,
+			e.cycles * 1000.0 / F_CPU, est * 1000.0 / F_CPU, POST_TIME_MS,
+			bus, simBus, sout);
+
+	int result = (received && (error == 0) && (ps.bus == simBus) &&
+			(bus == simBus) && (sout == TTests::POST_SOUT_PASS) &&
+			(est < US_TO_CYCLES(POST_TIME_MS * 1000UL))) ? 0 : 1;
+
+	std::vector<SFaultClass> cls = makeFaults(TSimBoard::FLASH_ADR,
+			TSimBoard::FLASH_SIZE, 15);
+	std::vector<SFaultClass> ram = makeFaults(TSimBoard::RAM_ADR,
+			TSimBoard::RAM_SIZE, 11);
+	std::vector<SFaultClass> plis = makePlisFaults();
+	cls.insert(cls.end(), ram.begin(), ram.end());
+	cls.insert(cls.end(), plis.begin(), plis.end());
+
+	for(size_t c = 0; c < cls.size(); c++) {
+		unsigned boots = (c < 5) ? POST_BOOTS : 1;
+		unsigned first = 0;
+		unsigned detected = 0;
+
+		for(size_t i = 0; i < cls[c].list.size(); i++) {
+			for(unsigned b = 0; b < boots; b++) {
+				if ((runPost(&cls[c].list[i], 0, b) != 0) &&
+						(simBoard.getSout() == TTests::POST_SOUT_FAIL)) {
+					first += (b == 0) ? 1 : 0;
+					detected++;
+					break;
+				}
+			}
+		}
+		printf("%-12s %-5s %-12s %3u/%-3u", "", (c < 5) ? "FRAM" :
+				((c < 10) ? "2RAM" : "PLIS"), cls[c].name, first,
+				static_cast<unsigned> (cls[c].list.size()));
+		if (boots > 1) {
+			printf(" %u boots %3u/%-3u", boots, detected,
+					static_cast<unsigned> (cls[c].list.size()));
+		}
+		printf("\n");
+	}
+	simBoard.clearFaults();
+
+	return result;
+}
+
+/**	Сохранение счетчика запусков самопроверки тестами FSM.
+ *
+ *	TEST_FRAM и TEST_BUS_BENCH пишут во всю FRAM, но счетчик запусков в
+ *	последней ячейке (TTests::POST_BOOT_ADR) должен остаться прежним.
+ *
+ *	@return 0 - счетчик не изменился, 1 - иначе.
+ */
+static int benchPostBoot() {
+	static const uint16_t BOOT_ADR = TSimBoard::FLASH_ADR +
+			TSimBoard::FLASH_SIZE - 1;
+	static const TTests::TESTS test[] = {
+			TTests::TEST_FRAM, TTests::TEST_BUS_BENCH
+	};
+	static const uint8_t BOOT = 5;
+	int result = 0;
+
+	testStat.magic = 0;
+	simBoard.clearFaults();
+	initBoard();
+	TTests t(&testStat);
+	tests = &t;
+
+	for(size_t i = 0; i < sizeof(test) / sizeof(test[0]); i++) {
+		simBoard.write(TSimBoard::PLIS_ADR + TSimBoard::PLIS_INIT, 0x55);
+		simBoard.write(BOOT_ADR, BOOT);
+		simBoard.write(TSimBoard::PLIS_ADR + TSimBoard::PLIS_INIT, 0x00);
+
+		t.setTest(test[i]);
+		while (t.getCurTest() == test[i]) {
+			t.main();
+			if (t.isIdle()) {
+				simBoard.sleep();
+			}
+		}
+
+		simBoard.write(TSimBoard::PLIS_ADR + TSimBoard::PLIS_INIT, 0x55);
+		uint8_t boot = simBoard.read(BOOT_ADR);
+		simBoard.write(TSimBoard::PLIS_ADR + TSimBoard::PLIS_INIT, 0x00);
+
+		printf("%-12s %-14s boot %u / %u\n", "post boot",
+				testName[test[i]], boot, BOOT);
+		result |= (boot == BOOT) ? 0 : 1;
+	}
+	tests = 0;
+
+	return result;
+}
+
+/**	Однократная проверка CRC программы (TTests::checkFlash()) на модели.
+ *
+ *	@param[out] fc Кадр TReport::TYPE_FLASH.
+ *	@param[out] bus Обращения к шине, учтенные проверкой (TStat).
+ *	@param print Вывод кадра.
+ *	@return Результат checkFlash().
+ */
+static bool runFlash(TReportDecoder::SFlash &fc, uint32_t &bus,
+		bool print) {
+	testStat.magic = 0;
+	TTests t(&testStat);
+	tests = &t;
+	initBoard();
+
+	uint32_t start = TStat::getBus();
+	bool ok = t.checkFlash();
+	bus = TStat::getBus() - start;
+
+	TReportDecoder dec;
+	const std::vector<uint8_t> &tx = simBoard.getUartTx();
+	fc = TReportDecoder::SFlash();
+	fc.result = 0xFF;
+	for(size_t j = 0; j < tx.size(); j++) {
+		if (dec.put(tx[j]) && dec.getFlash(fc) && print) {
+			dec.print(stdout);
+		}
+	}
+
+	return ok;
+}
+
+/**	Проверка CRC программы во flash при запуске.
+ *
+ *	Образ Debug/TestBSP.hex (без файла - случайный образ 8 КБ) и случайный
+ *	образ 64 КБ заполняются как в host/crcstamp (если в образе нет записи
+ *	TFlashCrc::SStamp, она добавляется в конец). Проверка должна пройти с
+ *	CRC, совпадающей с TFlashImage, и учетом обращений к шине (сбросы
+ *	сторожевого таймера). Выводится время модели (только чтения flash) и
+ *	оценка по FLASH_CRC_CYCLES_PER_BYTE. Затем ошибка должна быть найдена
+ *	при измененном бите образа и записи, а образ без записи - пройти как
+ *	незаполненный.
+ *
+ *	@return 0 - проверки прошли, 1 - иначе.
+ */
+static int benchFlashCrc() {
+	const uint8_t placeholder[] = { 'F', 'C', 'R', 'C', 0xFF, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+	std::mt19937 rnd(24);
+	int result = 0;
+
+	printf("\n");
+	for(int k = 0; k < 2; k++) {
+		TFlashImage img;
+
+		if ((k != 0) || !img.read("Debug/TestBSP.hex")) {
+			uint32_t size = (k != 0) ? 0x10000 : 0x2000;
+			for(uint32_t i = 0; i < size; i++) {
+				uint8_t val = rnd();
+				img.put(i, &val, 1);
+			}
+			img.put((k != 0) ? 0x100 : size - sizeof(placeholder),
+					placeholder, sizeof(placeholder));
+		}
+		if (img.findStamp() < 0) {
+			img.put((img.getEnd() + 3) & ~3UL, placeholder,
+					sizeof(placeholder));
+		}
+
+		long adr = img.findStamp();
+		std::string err = (adr < 0) ? "no stamp" : img.stamp(adr);
+		if (!err.empty()) {
+			printf("%-12s %s\n", "flash", err.c_str());
+			result = 1;
+			continue;
+		}
+		simBoard.flash.assign(img.data.begin(), img.data.begin() + 0x10000);
+		simBoard.flashStamp = adr;
+
+		TReportDecoder::SFlash fc;
+		uint32_t bus;
+		uint32_t len = img.getEnd();
+		bool ok = runFlash(fc, bus, true);
+		const TSimBoard::SStat &e = simBoard.getStat();
+		uint32_t simBus = e.busRead + e.busWrite;
+		uint64_t est = static_cast<uint64_t> (len) *
+				FLASH_CRC_CYCLES_PER_BYTE;
+
+		printf("%-12s %s %u B, %.2f ms (%.1f cyc/B), est %.1f ms, "
+				"wdt %u\n", "", (k != 0) ? "64K" : "image", len,
+				e.cycles * 1000.0 / F_CPU, e.cycles / static_cast<double> (len),
+				est * 1000.0 / F_CPU, bus);
+
+		uint32_t crc = img.get32(adr + offsetof(TFlashCrc::SStamp, crc));
+		if (!ok || (fc.result != TFlashCrc::RESULT_OK) || (fc.len != len) ||
+				(fc.crc != crc) || (bus != simBus) || (e.cycles > est)) {
+			result = 1;
+		}
+
+		// измененный бит образа и CRC в записи
+		simBoard.flash[len - 1] ^= 0x10;
+		ok = runFlash(fc, bus, false);
+		if (ok || (fc.result != TFlashCrc::RESULT_BAD) ||
+				(simBoard.getSout() != TTests::POST_SOUT_FAIL)) {
+			result = 1;
+		}
+		simBoard.flash[len - 1] ^= 0x10;
+		simBoard.flash[adr + offsetof(TFlashCrc::SStamp, crc)] ^= 0x01;
+		ok = runFlash(fc, bus, false);
+		if (ok || (fc.result != TFlashCrc::RESULT_BAD)) {
+			result = 1;
+		}
+	}
+
+	// стертая flash - записи нет
+	simBoard.flash.assign(0x10000, 0xFF);
+	simBoard.flashStamp = 0;
+
+	TReportDecoder::SFlash fc;
+	uint32_t bus;
+	if (!runFlash(fc, bus, false) ||
+			(fc.result != TFlashCrc::RESULT_UNSTAMPED)) {
+		result = 1;
+	}
+
+	return result;
+}
+
+/// Итоги плана тестов по кадрам TReport::TYPE_PLAN.
+struct SPlanRun {
+	unsigned frames;				///< Кадры плана.
+	TReportDecoder::SPlan last;		///< Последний кадр.
+	double rate;					///< Средняя скорость обмена, байт/с.
+};
+
+/**	Выполнение плана тестов, выбранного командой по USART1.
+ *
+ *	Тесты выполняются до окончания плана или до \a maxIter итераций.
+ *
+ *	@param t Тесты.
+ *	@param first Первый тест итерации.
+ *	@param last Последний тест итерации.
+ *	@param count Кол-во итераций.
+ *	@param flags Флаги плана.
+ *	@param maxIter Остановка после этого кол-ва итераций, 0 - по окончании.
+ *	@return Итоги по кадрам плана с последнего сброса платы.
+ */
+static SPlanRun runPlan(TTests &t, uint8_t first, uint8_t last,
+		uint16_t count, uint8_t flags, uint32_t maxIter) {
+	uint8_t cmd[TReport::CMD_DATA_MAX + 5];
+	uint8_t n = TReportDecoder::makePlanCmd(first, last, count, flags, cmd);
+
+	for(uint8_t i = 0; i < n; i++) {
+		simBoard.uartRx(cmd[i]);
+	}
+
+	// первый main() принимает команду
+	do {
+		t.main();
+		if (t.isIdle()) {
+			simBoard.sleep();
+		}
+	} while (!t.isPlanDone() && ((maxIter == 0) ||
+			(t.getPlan().iter < maxIter)));
+
+	SPlanRun r = SPlanRun();
+	TReportDecoder dec;
+	uint64_t bus = 0;
+	uint64_t ticks = 0;
+	const std::vector<uint8_t> &tx = simBoard.getUartTx();
+
+	for(size_t j = 0; j < tx.size(); j++) {
+		if (dec.put(tx[j]) && dec.getPlan(r.last)) {
+			r.frames++;
+			bus += r.last.bus;
+			ticks += r.last.ticks;
+		}
+	}
+	r.rate = (ticks != 0) ? bus * 1000.0 / (ticks * TICK_MS) : 0;
+
+	return r;
+}
+
+/**	Планы тестов.
+ *
+ *	На исправной плате: выдержка 2RAM с ожиданием тиков и без него
+ *	(PLAN_FULL_RATE), выдержка FRAM, последовательность автоматических
+ *	тестов дважды. С неисправностью FRAM: последовательность с остановкой
+ *	на первой ошибке и без нее. Выдержка FRAM продолжается после сброса МК
+ *	сторожевым таймером, неверный план не принимается. Для каждого плана
+ *	выводятся итерации, итерации с ошибками, длительность итерации и
+ *	скорость обмена с шиной по кадрам плана.
+ *
+ *	@return 0 - планы выполнены как заданы, 1 - иначе.
+ */
+static int benchPlan() {
+	struct SCase {
+		const char *name;		///< Название.
+		uint8_t first;			///< Первый тест итерации.
+		uint8_t last;			///< Последний тест итерации.
+		uint16_t count;			///< Кол-во итераций.
+		uint8_t flags;			///< Флаги плана.
+		bool fault;				///< Неисправность FRAM.
+		uint32_t failed;		///< Ожидаемые итерации с ошибками.
+	};
+	static const SCase cases[] = {
+		{ "2ram soak", TTests::TEST_2RAM, TTests::TEST_2RAM, 10, 0, false, 0 },
+		{ "2ram full", TTests::TEST_2RAM, TTests::TEST_2RAM, 10,
+				TTests::PLAN_FULL_RATE, false, 0 },
+		{ "fram full", TTests::TEST_FRAM, TTests::TEST_FRAM, 3,
+				TTests::PLAN_FULL_RATE, false, 0 },
+		{ "sequence x2", TTests::TEST_PLIS_REG, TTests::TEST_2RAM, 2,
+				TTests::PLAN_FULL_RATE, false, 0 },
+		{ "stop on fail", TTests::TEST_PLIS_REG, TTests::TEST_2RAM, 5,
+				TTests::PLAN_STOP_ON_FAIL, true, 1 },
+		{ "fail x2", TTests::TEST_PLIS_REG, TTests::TEST_2RAM, 2, 0, true, 2 }
+	};
+	std::vector<SFaultClass> fram = makeFaults(TSimBoard::FLASH_ADR,
+			TSimBoard::FLASH_SIZE, 15);
+	int result = 0;
+
+	printf("\n%-12s %6s %6s %6s %10s %10s\n", "plan", "iter", "failed",
+			"frames", "iter_ms", "kb_s");
+	for(size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+		const SCase &k = cases[c];
+
+		testStat.magic = 0;
+		TTests t(&testStat);
+		tests = &t;
+		simBoard.clearFaults();
+		if (k.fault) {
+			simBoard.addFault(fram[1].list[0]);
+		}
+		initBoard();
+		t.resume(MCUCSR);
+
+		SPlanRun r = runPlan(t, k.first, k.last, k.count, k.flags, 0);
+		const TTests::SPlan &p = t.getPlan();
+		uint32_t iter = (k.flags & TTests::PLAN_STOP_ON_FAIL) ? 1 : k.count;
+		uint8_t sout = (k.failed != 0) ? TTests::POST_SOUT_FAIL :
+				TTests::POST_SOUT_PASS;
+
+		printf("%-12s %6u %6u %6u %10.1f %10.1f\n", k.name, p.iter, p.failed,
+				r.frames, simBoard.getStat().cycles * 1000.0 / F_CPU / p.iter,
+				r.rate / 1024);
+
+		if ((p.iter != iter) || (p.failed != k.failed) ||
+				(r.frames != iter + 1) || (r.last.iter != iter) ||
+				!(r.last.flags & TTests::PLAN_DONE) ||
+				((k.failed != 0) &&
+						!(r.last.mask & (1 << TTests::TEST_FRAM))) ||
+				(simBoard.getSout() != sout)) {
+			result = 1;
+		}
+	}
+	simBoard.clearFaults();
+
+	// продолжение выдержки после сброса МК
+	{
+		testStat.magic = 0;
+		TTests t(&testStat);
+		tests = &t;
+		initBoard();
+		t.resume(MCUCSR);
+		runPlan(t, TTests::TEST_FRAM, TTests::TEST_FRAM, 4, 0, 2);
+	}
+	TTests t(&testStat);
+	tests = &t;
+	initBoard();
+	t.resume(1 << WDRF);
+
+	// неверный план: FRAM -> 2RAM -> EXT_BUS, PLIS_REG недостижим
+	SPlanRun r = runPlan(t, TTests::TEST_FRAM, TTests::TEST_PLIS_REG, 1, 0,
+			0);
+	const TTests::SPlan &p = t.getPlan();
+	printf("%-12s %6u %6u %6u\n", "resumed", p.iter, p.failed, r.frames);
+	if ((p.iter != 4) || (p.count != 4) || (p.first != TTests::TEST_FRAM) ||
+			(r.frames != 3) || (r.last.iter != 4)) {
+		result = 1;
+	}
+
+	testStat.magic = 0;
+
+	return result;
+}
+
+int main(int argc, char *argv[]) {
+	int fd = -1;
+
+	if ((argc > 2) && (strcmp(argv[1], "-u") == 0)) {
+		fd = open(argv[2], O_WRONLY | O_NOCTTY);
+		if (fd < 0) {
+			perror(argv[2]);
+			return 2;
+		}
+	}
+
+	simBoard.setUartFd(fd);
+	int result = benchTests(false);
+	simBoard.setUartFd(-1);
+	if (fd >= 0) {
+		close(fd);
+	}
+	result |= benchSettleTimeout();
+	result |= benchResume();
+	result |= benchResumeHang();
+	result |= benchSweep();
+	result |= benchBusBench();
+	result |= benchStress();
+	result |= benchStressError();
+	result |= benchPost();
+	result |= benchPostBoot();
+	result |= benchFlashCrc();
+	result |= benchPlan();
+
+	printf("\n");
+	result |= benchTests(true);
+
+	printf("\n%-12s %10s %10s %10s\n", "pattern", "pgm", "mcu_lpm",
+			"host_ns/b");
+	benchPattern<TPatternCrc8>("crc8");
+	benchPattern<TPatternXorshift>("xorshift");
+	benchPattern<TPatternWalking>("walking");
+	benchPattern<TPatternChecker>("checker");
+
+	printf("\n%-12s %10s %10s %10s %10s\n", "read pass", "bus_rd/b",
+			"pgm/b", "mcu_cyc/b", "host_ns/b");
+	benchSignature<TSigNone>("compare");
+	benchSignature<TSigCrc16>("crc16");
+	benchSignature<TSigCrc16Nibble>("crc16 nib");
+	benchSignature<TSigCrc32>("crc32");
+	benchSignature<TSigCrc32Nibble>("crc32 nib");
+
+	benchVerify("FRAM", TTests::TEST_FRAM, TSimBoard::FLASH_ADR,
+			TSimBoard::FLASH_SIZE, 15);
+	benchVerify("2RAM", TTests::TEST_2RAM, TSimBoard::RAM_ADR,
+			TSimBoard::RAM_SIZE, 11);
+
+	benchFailLog("FRAM", TTests::TEST_FRAM, TSimBoard::FLASH_ADR,
+			TSimBoard::FLASH_SIZE, 15);
+	benchFailLog("2RAM", TTests::TEST_2RAM, TSimBoard::RAM_ADR,
+			TSimBoard::RAM_SIZE, 11);
+
+	benchCoverage("FRAM", TTests::TEST_FRAM, TSimBoard::FLASH_ADR,
+			TSimBoard::FLASH_SIZE, 15);
+	benchCoverage("2RAM", TTests::TEST_2RAM, TSimBoard::RAM_ADR,
+			TSimBoard::RAM_SIZE, 11);
+
+	benchDetect();
+
+	return result;
+}
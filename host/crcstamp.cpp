@@ -0,0 +1,61 @@
+/*
+ * crcstamp.cpp
+ *
+ *	Запись длины и CRC-32 программы в файл прошивки (TFlashCrc).
+ *
+ *	Использование:
+ *	crcstamp <файл.hex> [<выходной файл.hex>]
+ *
+ *	В образе ищется запись TFlashCrc::STAMP (по признаку
+ *	TFlashCrc::MAGIC), в нее записываются длина образа и CRC-32, файл
+ *	перезаписывается (или записывается выходной файл). Выводятся адрес
+ *	записи, длина, CRC и оценка времени проверки при запуске МК по
+ *	FLASH_CRC_CYCLES_PER_BYTE. Повторная обработка того же файла дает ту же
+ *	CRC. Программа возвращает 1 при ошибке.
+ *
+ *	Сборка описана в readme.txt.
+ */
+#include <stdio.h>
+
+#include "../inc/TTiming.h"
+#include "TFlashImage.h"
+
+int main(int argc, char *argv[]) {
+	if ((argc != 2) && (argc != 3)) {
+		fprintf(stderr, "usage: crcstamp <file.hex> [<out.hex>]\n");
+		return 1;
+	}
+
+	const char *out = (argc == 3) ? argv[2] : argv[1];
+	TFlashImage img;
+
+	if (!img.read(argv[1])) {
+		fprintf(stderr, "%s: read error\n", argv[1]);
+		return 1;
+	}
+
+	long adr = img.findStamp();
+	if (adr < 0) {
+		fprintf(stderr, "%s: no single stamp record found\n", argv[1]);
+		return 1;
+	}
+
+	std::string err = img.stamp(adr);
+	if (!err.empty()) {
+		fprintf(stderr, "%s: %s\n", argv[1], err.c_str());
+		return 1;
+	}
+
+	if (!img.write(out)) {
+		fprintf(stderr, "%s: write error\n", out);
+		return 1;
+	}
+
+	uint32_t len = img.get32(adr + offsetof(TFlashCrc::SStamp, len));
+	printf("stamp 0x%04lX len %u crc 0x%08X boot %.1f ms\n", adr, len,
+			img.get32(adr + offsetof(TFlashCrc::SStamp, crc)),
+			len * static_cast<double> (FLASH_CRC_CYCLES_PER_BYTE) /
+			(F_CPU / 1000));
+
+	return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * decoder.cpp
+ *
+ *	Расшифровка результатов тестов, переданных платой по USART1 (TReport).
+ *
+ *	Использование:
+ *	- decoder - поток берется со стандартного ввода;
+ *	- decoder <файл> - из файла или последовательного порта (порт
+ *	переводится в режим raw со скоростью UART_BAUD);
+ *	- decoder -p - создается псевдотерминал, имя которого выводится первой
+ *	строкой, поток берется из него (например, от bench -u <имя>);
+ *	- decoder -P <first>,<last>,<count>,<flags> <порт> - перед приемом в
+ *	порт передается команда выбора плана тестов (TReport::CMD_PLAN, номера
+ *	тестов TTests::TESTS, флаги TTests::PLAN_FLAG), например
+ *	-P 4,4,0,2 - FRAM по кругу без ожидания тиков, -P 0,0,0,0 - без плана.
+ *
+ *	Каждый кадр выводится одной строкой, в конце - кол-во кадров, ошибок
+ *	CRC и пропущенных кадров. Программа возвращает 1, если был хотя бы один
+ *	кадр с ошибкой теста или самопроверки или ошибкой CRC.
+ *
+ *	Сборка описана в readme.txt.
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "TReportDecoder.h"
+
+/**	Создание псевдотерминала в режиме raw.
+ *
+ *	@return Дескриптор ведущей стороны или -1.
+ */
+static int openPty() {
+	int fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if ((fd < 0) || (grantpt(fd) != 0) || (unlockpt(fd) != 0)) {
+		perror("posix_openpt");
+		return -1;
+	}
+
+	struct termios tio;
+	if (tcgetattr(fd, &tio) == 0) {
+		cfmakeraw(&tio);
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+
+	printf("%s\n", ptsname(fd));
+	fflush(stdout);
+
+	return fd;
+}
+
+/**	Открытие файла или последовательного порта.
+ *
+ *	@param path Имя файла.
+ *	@param rw True - файл открывается и для записи.
+ *	@return Дескриптор или -1.
+ */
+static int openFile(const char *path, bool rw) {
+	int fd = open(path, (rw ? O_RDWR : O_RDONLY) | O_NOCTTY);
+
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+
+	struct termios tio;
+	if (isatty(fd) && (tcgetattr(fd, &tio) == 0)) {
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, B1000000);
+		cfsetospeed(&tio, B1000000);
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+
+	return fd;
+}
+
+int main(int argc, char *argv[]) {
+	TReportDecoder dec;
+	bool fail = false;
+	int fd = STDIN_FILENO;
+	int plan[4];
+	bool cmd = (argc > 3) && (strcmp(argv[1], "-P") == 0);
+
+	if (cmd) {
+		if (sscanf(argv[2], "%i,%i,%i,%i", &plan[0], &plan[1], &plan[2],
+				&plan[3]) != 4) {
+			fprintf(stderr, "bad plan %s\n", argv[2]);
+			return 2;
+		}
+		fd = openFile(argv[3], true);
+	} else if ((argc > 1) && (strcmp(argv[1], "-p") == 0)) {
+		fd = openPty();
+	} else if (argc > 1) {
+		fd = openFile(argv[1], false);
+	}
+
+	if (fd < 0)
+		return 2;
+
+	if (cmd) {
+		uint8_t buf[TReport::CMD_DATA_MAX + 5];
+		uint8_t n = TReportDecoder::makePlanCmd(plan[0], plan[1], plan[2],
+				plan[3], buf);
+
+		if (write(fd, buf, n) != n) {
+			perror(argv[3]);
+			return 2;
+		}
+	}
+
+	uint8_t buf[256];
+	ssize_t n;
+
+	// для псевдотерминала закрытие ведомой стороны дает EIO
+	while ((n = read(fd, buf, sizeof(buf))) > 0) {
+		for(ssize_t i = 0; i < n; i++) {
+			TReportDecoder::SResult res;
+			TReportDecoder::SPost ps;
+			TReportDecoder::SFlash fc;
+
+			if (!dec.put(buf[i]))
+				continue;
+
+			dec.print(stdout);
+			if ((dec.getResult(res) && (res.error != 0)) ||
+					(dec.getPost(ps) && (ps.error != 0)) ||
+					(dec.getFlash(fc) &&
+							(fc.result == TFlashCrc::RESULT_BAD))) {
+				fail = true;
+			}
+		}
+		fflush(stdout);
+	}
+
+	printf("frames %u, crc errors %u, lost %u\n", dec.getFrames(),
+			dec.getCrcErrors(), dec.getLost());
+
+	return (fail || (dec.getCrcErrors() != 0)) ? 1 : 0;
+}
@@ -0,0 +1,430 @@
+/*
+ * runner.cpp
+ *
+ *	Проверка тестов TTests на множестве моделей плат с неисправностями.
+ *
+ *	Использование:
+ *	runner [-n <платы>] [-j <потоки>] [-s <seed>] [-f <файл>] [-v]
+ *	- -n - кол-во плат со случайными неисправностями (по умолчанию 256),
+ *	примерно каждая пятая плата исправна;
+ *	- -j - кол-во потоков, по умолчанию по кол-ву ядер;
+ *	- -s - начальное значение генератора неисправностей;
+ *	- -f - неисправности плат из файла вместо случайных: строка - плата,
+ *	"-" - исправная плата, иначе неисправности через ';', каждая - семь
+ *	чисел полей TSimBoard::SFault (type adr adr2 mask val line line2),
+ *	строки с '#' - комментарии;
+ *	- -v - результат каждой платы.
+ *
+ *	Каждая плата - своя модель TSimBoard в потоке пула TStealPool.
+ *	Тесты FSM проходятся от TEST_PLIS_REG до TEST_2RAM (проверки
+ *	светодиодов SOut и внешней шины на модели не нужны) до первой ошибки,
+ *	тики Timer1 (setFlag()) подает runner из прерывания модели.
+ *
+ *	Для каждого класса неисправностей выводится кол-во плат, прошедших и
+ *	не прошедших тесты, среднее и наибольшее время МК до отбраковки и
+ *	тесты, обнаружившие ошибку. Программа возвращает 1, если не прошла
+ *	хотя бы одна исправная плата.
+ *
+ *	Сборка описана в readme.txt.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../inc/TTests.h"
+#include "TReportDecoder.h"
+#include "TStealPool.h"
+
+/// Период прерывания Timer1 в тактах МК (см. low_level_init()).
+static const uint32_t TICK_CYCLES = TIMER1_PRESCALER * (TIMER1_OCR + 1UL);
+
+/// Тесты платы текущего потока.
+static thread_local TTests *tests;
+
+/// Плата.
+struct SBoard {
+	std::vector<TSimBoard::SFault> faults;	///< Неисправности.
+	TTests::TESTS test;		///< Тест с ошибкой, TEST_EXT_BUS - тесты прошли.
+	uint8_t error;			///< Код ошибки теста.
+	uint64_t cycles;		///< Время до окончания или ошибки, тактов МК.
+	uint32_t bus;			///< Обращения к шине.
+	int64_t cpuUs;			///< Время процессора ПК в потоке платы, мкс.
+};
+
+/// Итоги класса неисправностей.
+struct SClass {
+	unsigned boards;		///< Кол-во плат.
+	unsigned fail;			///< Не прошли тесты.
+	uint64_t cycles;		///< Суммарное время до отбраковки, тактов МК.
+	uint64_t maxCycles;		///< Наибольшее время до отбраковки, тактов МК.
+	unsigned test[TTests::TEST_MAX];	///< Кол-во отбраковок по тестам.
+};
+
+// Прерывание Timer1
+static void isrTimer1() {
+	tests->setFlag();
+}
+
+/**	Сброс платы и настройка периферии, как в low_level_init().
+ *
+ */
+static void initBoard() {
+	simBoard.reset();
+	simBoard.setTimer(TICK_CYCLES, isrTimer1);
+
+	XMCRA = 0x06;
+	MCUCR = (1 << SRE);
+
+	UBRR1H = (UART_UBRR >> 8);
+	UBRR1L = (UART_UBRR & 0xFF);
+	UCSR1A = (1 << U2X1);
+	UCSR1C = (1 << UCSZ11) | (1 << UCSZ10);
+	UCSR1B = (1 << TXEN1);
+}
+
+/**	Время процессора, занятое текущим потоком.
+ *
+ *	В отличие от времени по часам, не включает время, когда поток ждал
+ *	процессор, занятый другими потоками.
+ *
+ *	@return Время, мкс.
+ */
+static int64_t getCpuUs() {
+	timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return static_cast<int64_t> (ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**	Проверка платы на модели текущего потока.
+ *
+ *	@param[in,out] b Плата.
+ */
+static void runBoard(SBoard &b) {
+	int64_t t0 = getCpuUs();
+	TTests::SStatBlock block;
+	memset(&block, 0, sizeof(block));
+
+	simBoard.clearFaults();
+	for(size_t i = 0; i < b.faults.size(); i++) {
+		simBoard.addFault(b.faults[i]);
+	}
+	initBoard();
+
+	TTests t(&block);
+	tests = &t;
+	t.setTest(TTests::TEST_PLIS_REG);
+
+	TTests::TESTS cur = t.getCurTest();
+	while (cur != TTests::TEST_EXT_BUS) {
+		while (!t.main() && (t.getError() == 0)) {
+			if (t.isIdle()) {
+				simBoard.sleep();
+			}
+		}
+
+		if (t.getError() != 0)
+			break;
+		cur = t.getCurTest();
+	}
+
+	b.test = cur;
+	b.error = t.getError();
+	b.cycles = simBoard.getStat().cycles;
+	b.bus = simBoard.getStat().busRead + simBoard.getStat().busWrite;
+	b.cpuUs = getCpuUs() - t0;
+	tests = 0;
+}
+
+/**	Случайная неисправность.
+ *
+ *	Классы: для FRAM и 2RAM - залипание разрядов ячейки, линии данных,
+ *	связь ячеек, залипание (обрыв) и замыкание линий адреса; для ПЛИС -
+ *	залипание и замыкание линий адреса, совпадение регистров, залипание
+ *	разряда BusR и перепутанные разряды BusW -> BusR.
+ *
+ *	@param rnd Генератор.
+ *	@return Неисправность.
+ */
+static TSimBoard::SFault makeFault(std::mt19937 &rnd) {
+	// регистры записи/чтения ПЛИС
+	static const uint8_t reg[] = {
+			TSimBoard::PLIS_INIT, TSimBoard::PLIS_DD_L, TSimBoard::PLIS_DD_H,
+			TSimBoard::PLIS_CUR_ADR, TSimBoard::PLIS_EXT_SET,
+			TSimBoard::PLIS_BUS_W, TSimBoard::PLIS_BANK_FL
+	};
+	static const uint8_t REGS = sizeof(reg) / sizeof(reg[0]);
+	TSimBoard::SFault f = TSimBoard::SFault();
+	unsigned kind = rnd() % 15;
+	bool fram = (kind < 5);
+	uint16_t base = fram ? TSimBoard::FLASH_ADR : TSimBoard::RAM_ADR;
+	uint16_t size = fram ? TSimBoard::FLASH_SIZE : TSimBoard::RAM_SIZE;
+	uint8_t lines = fram ? 15 : 11;
+
+	f.adr = base;
+	if (kind >= 10) {
+		f.adr = TSimBoard::PLIS_ADR;
+		lines = 4;
+	}
+
+	switch(kind % 5 + ((kind >= 10) ? 5 : 0)) {
+		case 0:
+			f.type = TSimBoard::FAULT_STUCK;
+			f.adr = base + rnd() % size;
+			f.mask = 1 << (rnd() % 8);
+			f.val = (rnd() & 1) ? 0xFF : 0x00;
+			break;
+		case 1:
+			f.type = TSimBoard::FAULT_DATA;
+			f.mask = 1 << (rnd() % 8);
+			f.val = (rnd() & 1) ? 0xFF : 0x00;
+			break;
+		case 2:
+			f.type = TSimBoard::FAULT_COUPLING;
+			f.adr = base + rnd() % size;
+			do {
+				f.adr2 = base + rnd() % size;
+			} while (f.adr2 == f.adr);
+			f.mask = 1 << (rnd() % 8);
+			break;
+		case 3:
+		case 5:
+			f.type = TSimBoard::FAULT_ADR_STUCK;
+			f.line = rnd() % lines;
+			f.val = rnd() & 1;
+			break;
+		case 4:
+		case 6:
+			f.type = TSimBoard::FAULT_ADR_SHORT;
+			f.line = rnd() % (lines - 1);
+			f.line2 = f.line + 1;
+			break;
+		case 7: {
+			uint8_t i = rnd() % REGS;
+			uint8_t j = (i + 1 + rnd() % (REGS - 1)) % REGS;
+			f.type = TSimBoard::FAULT_ALIAS;
+			f.adr = TSimBoard::PLIS_ADR + reg[i];
+			f.adr2 = TSimBoard::PLIS_ADR + reg[j];
+			break;
+		}
+		case 8:
+			f.type = TSimBoard::FAULT_STUCK;
+			f.adr = TSimBoard::PLIS_ADR + TSimBoard::PLIS_BUS_R;
+			f.mask = 1 << (rnd() % 8);
+			f.val = (rnd() & 1) ? 0xFF : 0x00;
+			break;
+		default:
+			f.type = TSimBoard::FAULT_BUS_MAP;
+			f.line = rnd() % 8;
+			f.line2 = (f.line + 1 + rnd() % 7) % 8;
+			break;
+	}
+
+	return f;
+}
+
+/**	Название класса неисправности.
+ *
+ *	@param f Неисправность.
+ *	@return Область и тип неисправности.
+ */
+static std::string getClass(const TSimBoard::SFault &f) {
+	static const char * const typeName[] = {
+			"stuck-at", "data line", "coupling", "adr stuck", "adr short",
+			"alias", "busR map"
+	};
+
+	if (f.type == TSimBoard::FAULT_BUS_MAP)
+		return "PLIS busR map";
+
+	const char *area = "2RAM";
+	if (f.adr >= TSimBoard::FLASH_ADR) {
+		area = "FRAM";
+	} else if (f.adr >= TSimBoard::PLIS_ADR) {
+		area = "PLIS";
+	}
+
+	if (f.type > TSimBoard::FAULT_BUS_MAP)
+		return std::string(area) + " ?";
+
+	return std::string(area) + " " + typeName[f.type];
+}
+
+/**	Чтение неисправностей плат из файла.
+ *
+ *	@param name Имя файла.
+ *	@param[out] boards Платы.
+ *	@return False - ошибка чтения или формата.
+ */
+static bool readBoards(const char *name, std::vector<SBoard> &boards) {
+	FILE *file = fopen(name, "r");
+	char line[1024];
+	unsigned num = 0;
+
+	if (file == 0) {
+		perror(name);
+		return false;
+	}
+
+	while (fgets(line, sizeof(line), file) != 0) {
+		num++;
+		char *p = line + strspn(line, " \t");
+
+		if ((*p == '#') || (*p == '\n') || (*p == '\r') || (*p == 0))
+			continue;
+
+		SBoard b = SBoard();
+		if (*p != '-') {
+			for(char *s = strtok(p, ";"); s != 0; s = strtok(0, ";")) {
+				int v[7];
+				if (sscanf(s, "%i %i %i %i %i %i %i", &v[0], &v[1], &v[2],
+						&v[3], &v[4], &v[5], &v[6]) != 7) {
+					fprintf(stderr, "%s:%u: 7 fields expected\n", name, num);
+					fclose(file);
+					return false;
+				}
+
+				TSimBoard::SFault f;
+				f.type = v[0];
+				f.adr = v[1];
+				f.adr2 = v[2];
+				f.mask = v[3];
+				f.val = v[4];
+				f.line = v[5];
+				f.line2 = v[6];
+				b.faults.push_back(f);
+			}
+		}
+		boards.push_back(b);
+	}
+	fclose(file);
+
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	unsigned num = 256;
+	unsigned threads = 0;
+	unsigned seed = 1;
+	const char *file = 0;
+	bool verbose = false;
+
+	for(int i = 1; i < argc; i++) {
+		if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+			num = strtoul(argv[++i], 0, 0);
+		} else if ((strcmp(argv[i], "-j") == 0) && (i + 1 < argc)) {
+			threads = strtoul(argv[++i], 0, 0);
+		} else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+			seed = strtoul(argv[++i], 0, 0);
+		} else if ((strcmp(argv[i], "-f") == 0) && (i + 1 < argc)) {
+			file = argv[++i];
+		} else if (strcmp(argv[i], "-v") == 0) {
+			verbose = true;
+		} else {
+			fprintf(stderr, "usage: runner [-n boards] [-j threads] "
+					"[-s seed] [-f file] [-v]\n");
+			return 2;
+		}
+	}
+
+	std::vector<SBoard> boards;
+	if (file != 0) {
+		if (!readBoards(file, boards))
+			return 2;
+	} else {
+		boards.resize(num);
+		for(unsigned i = 0; i < num; i++) {
+			// неисправности платы не зависят от кол-ва потоков
+			std::mt19937 rnd(seed * 1000003U + i);
+			if (rnd() % 5 != 0) {
+				boards[i].faults.push_back(makeFault(rnd));
+			}
+		}
+	}
+
+	// модели плат создаются по одной на поток, сбрасываются на каждой плате
+	TStealPool pool(threads);
+	std::vector<std::unique_ptr<TSimBoard> > sim(pool.getThreads());
+	for(size_t i = 0; i < sim.size(); i++) {
+		sim[i].reset(new TSimBoard());
+	}
+
+	std::chrono::steady_clock::time_point t0 =
+			std::chrono::steady_clock::now();
+	pool.run(boards.size(), [&](size_t job, unsigned worker) {
+		simBoardCur = sim[worker].get();
+		runBoard(boards[job]);
+	});
+	int64_t wallUs = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - t0).count();
+
+	std::map<std::string, SClass> cls;
+	int64_t cpuUs = 0;
+	int result = 0;
+
+	for(size_t i = 0; i < boards.size(); i++) {
+		const SBoard &b = boards[i];
+		std::string name = b.faults.empty() ? "none" : getClass(b.faults[0]);
+		SClass &c = cls[name];
+		bool fail = (b.error != 0);
+
+		c.boards++;
+		if (fail) {
+			c.fail++;
+			c.cycles += b.cycles;
+			if (b.cycles > c.maxCycles) {
+				c.maxCycles = b.cycles;
+			}
+			c.test[b.test]++;
+			if (b.faults.empty()) {
+				result = 1;
+			}
+		}
+		cpuUs += b.cpuUs;
+
+		if (verbose) {
+			printf("board %-5u %-16s %-12s 0x%02X %10.1f ms %8u bus\n",
+					static_cast<unsigned> (i), name.c_str(),
+					fail ? testName[b.test] : "pass", b.error,
+					b.cycles * 1000.0 / F_CPU, b.bus);
+		}
+	}
+
+	printf("%-16s %6s %6s %6s %10s %10s  %s\n", "class", "boards", "pass",
+			"fail", "rej_ms", "max_ms", "rejected by");
+	for(std::map<std::string, SClass>::const_iterator i = cls.begin();
+			i != cls.end(); ++i) {
+		const SClass &c = i->second;
+
+		printf("%-16s %6u %6u %6u", i->first.c_str(), c.boards,
+				c.boards - c.fail, c.fail);
+		if (c.fail == 0) {
+			printf(" %10s %10s  -\n", "-", "-");
+			continue;
+		}
+		printf(" %10.1f %10.1f ", c.cycles * 1000.0 / F_CPU / c.fail,
+				c.maxCycles * 1000.0 / F_CPU);
+		for(int t = 0; t < TTests::TEST_MAX; t++) {
+			if (c.test[t] != 0) {
+				printf(" %s:%u", testName[t], c.test[t]);
+			}
+		}
+		printf("\n");
+	}
+
+	// ускорение - процессорное время плат на время по часам
+	printf("\n%u boards, %u threads, %u steals, wall %.2f s, "
+			"cpu %.2f s (x%.1f)\n", static_cast<unsigned> (boards.size()),
+			pool.getThreads(), static_cast<unsigned> (pool.getSteals()),
+			wallUs / 1e6, cpuUs / 1e6,
+			(wallUs != 0) ? static_cast<double> (cpuUs) / wallUs : 0.0);
+
+	return result;
+}
@@ -0,0 +1,26 @@
+/*
+ * util/delay.h
+ *
+ *	Замена util/delay.h для сборки на ПК: задержка продвигает время модели.
+ */
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include "../TSimBoard.h"
+
+#ifndef F_CPU
+#error "F_CPU not defined"
+#endif
+
+/// Задержка в мкс.
+static inline void _delay_us(double us) {
+	simBoard.advance(static_cast<uint32_t> (us * (F_CPU / 1000000UL)));
+}
+
+/// Задержка в мс.
+static inline void _delay_ms(double ms) {
+	simBoard.advance(static_cast<uint32_t> (ms * (F_CPU / 1000UL)));
+}
+
+#endif /* HOST_UTIL_DELAY_H_ */
@@ -0,0 +1,157 @@
+/*
+ * TBusBench.h
+ *
+ *	Замер пропускной способности внешней шины.
+ */
+
+#ifndef TBUSBENCH_H_
+#define TBUSBENCH_H_
+
+#include <stdint.h>
+#include "TExtBus.h"
+#include "TStat.h"
+
+/**	\brief Замер пропускной способности внешней шины.
+ *
+ *	Замер - BYTES обращений одного вида к области внешней шины, время
+ *	берется из TStat::now() (Timer3). Виды обращений (KIND) - сочетания:
+ *	- OP: чтение, запись, чтение-модификация-запись;
+ *	- ORDER: подряд или вразброс (шаг STRIDE, за BYTES обращений каждый
+ *	адрес области встречается одинаковое число раз);
+ *	- LOOP: цикл по байту или развернутый по 8 байт.
+ *
+ *	Циклы - шаблоны, поэтому каждый вид компилируется в отдельный цикл без
+ *	ветвлений внутри и замер показывает стоимость именно этого кода.
+ *	Адрес обращения - (начало + смещение) & MASK, размер области должен
+ *	быть степенью двойки, область из одного регистра - MASK = 0.
+ */
+class TBusBench {
+
+public:
+	/// Операции
+	enum OP {
+		OP_READ		= 0,	///< Чтение.
+		OP_WRITE	= 1,	///< Запись.
+		OP_RMW		= 2,	///< Чтение-модификация-запись.
+		OP_MAX				///< Кол-во операций.
+	};
+
+	/// Порядок адресов
+	enum ORDER {
+		ORDER_SEQ	= 0,	///< Подряд.
+		ORDER_RAND	= 1,	///< Вразброс.
+		ORDER_MAX			///< Кол-во вариантов.
+	};
+
+	/// Циклы
+	enum LOOP {
+		LOOP_BYTE	= 0,	///< По байту.
+		LOOP_UNROLL	= 1,	///< Развернутый по 8 байт.
+		LOOP_MAX			///< Кол-во вариантов.
+	};
+
+	/// Кол-во видов обращений.
+	static const uint8_t KIND_MAX = OP_MAX * ORDER_MAX * LOOP_MAX;
+
+	/// Кол-во байт одного замера.
+	static const uint16_t BYTES = 1024;
+
+	/// Шаг адреса для обращений вразброс (нечетный).
+	static const uint16_t STRIDE = 0x09E5;
+
+	/**	Вид обращений.
+	 *
+	 *	@param op Операция.
+	 *	@param order Порядок адресов.
+	 *	@param loop Цикл.
+	 *	@return Номер вида, 0..KIND_MAX-1.
+	 */
+	static uint8_t getKind(OP op, ORDER order, LOOP loop) {
+		return (op * ORDER_MAX + order) * LOOP_MAX + loop;
+	}
+
+	/**	Замер.
+	 *
+	 *	@param kind Вид обращений.
+	 *	@return Время BYTES обращений, тактов МК.
+	 */
+	template <uint16_t ADR, uint16_t MASK>
+	static uint32_t run(uint8_t kind) {
+		uint32_t start = TStat::now();
+
+		switch(kind) {
+			case  0: loop<ADR, MASK, OP_READ,  1,      false> (); break;
+			case  1: loop<ADR, MASK, OP_READ,  1,      true > (); break;
+			case  2: loop<ADR, MASK, OP_READ,  STRIDE, false> (); break;
+			case  3: loop<ADR, MASK, OP_READ,  STRIDE, true > (); break;
+			case  4: loop<ADR, MASK, OP_WRITE, 1,      false> (); break;
+			case  5: loop<ADR, MASK, OP_WRITE, 1,      true > (); break;
+			case  6: loop<ADR, MASK, OP_WRITE, STRIDE, false> (); break;
+			case  7: loop<ADR, MASK, OP_WRITE, STRIDE, true > (); break;
+			case  8: loop<ADR, MASK, OP_RMW,   1,      false> (); break;
+			case  9: loop<ADR, MASK, OP_RMW,   1,      true > (); break;
+			case 10: loop<ADR, MASK, OP_RMW,   STRIDE, false> (); break;
+			case 11: loop<ADR, MASK, OP_RMW,   STRIDE, true > (); break;
+		}
+
+		uint32_t cycles = TStat::now() - start;
+		TStat::addBus((kind >= getKind(OP_RMW, ORDER_SEQ, LOOP_BYTE)) ?
+				2 * BYTES : BYTES);
+
+		return cycles;
+	}
+
+private:
+	/**	Обращение к ячейке.
+	 *
+	 *	@param c Ячейка.
+	 *	@param[in,out] acc Считанные данные (OP_READ) или записываемое
+	 *	значение (OP_WRITE).
+	 */
+	template <uint8_t OP>
+	static inline void access(volatile EXT_REG(uint8_t) &c, uint8_t &acc) {
+		if (OP == OP_READ) {
+			acc ^= c;
+		} else if (OP == OP_WRITE) {
+			c = acc++;
+		} else {
+			c = c + 1;
+		}
+	}
+
+	/**	Цикл обращений одного вида.
+	 *
+	 */
+	template <uint16_t ADR, uint16_t MASK, uint8_t OP, uint16_t STEP,
+			bool UNROLL>
+	static void loop() {
+		volatile EXT_REG(uint8_t) *p = extPtr<EXT_REG(uint8_t)> (ADR);
+		uint16_t off = 0;
+		uint8_t acc = 0;
+
+		if (UNROLL) {
+			for(uint16_t i = BYTES / 8; i != 0; i--) {
+				access<OP> (p[(off + 0 * STEP) & MASK], acc);
+				access<OP> (p[(off + 1 * STEP) & MASK], acc);
+				access<OP> (p[(off + 2 * STEP) & MASK], acc);
+				access<OP> (p[(off + 3 * STEP) & MASK], acc);
+				access<OP> (p[(off + 4 * STEP) & MASK], acc);
+				access<OP> (p[(off + 5 * STEP) & MASK], acc);
+				access<OP> (p[(off + 6 * STEP) & MASK], acc);
+				access<OP> (p[(off + 7 * STEP) & MASK], acc);
+				off += 8 * STEP;
+			}
+		} else {
+			for(uint16_t i = BYTES; i != 0; i--) {
+				access<OP> (p[off & MASK], acc);
+				off += STEP;
+			}
+		}
+
+		sink = acc;
+	}
+
+	static volatile uint8_t sink;		///< Результат чтения (не удаляется).
+};
+
+#endif /* TBUSBENCH_H_ */
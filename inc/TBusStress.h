@@ -0,0 +1,145 @@
+/*
+ * TBusStress.h
+ *
+ *	Нагрузка на внешнюю шину из прерывания Timer2.
+ */
+
+#ifndef TBUSSTRESS_H_
+#define TBUSSTRESS_H_
+
+#include <avr/io.h>
+#include <stdint.h>
+#include "TExtBus.h"
+#include "TTiming.h"
+#include "TStat.h"
+
+/**	\brief Нагрузка на внешнюю шину из прерывания.
+ *
+ *	Пока нагрузка запущена, каждые STRESS_PERIOD_US в прерывании Timer2
+ *	(isr()) в окно 2RAM и в регистр ПЛИС записывается следующее значение
+ *	последовательности и сразу считывается. Ячейка окна, записанная в
+ *	предыдущем прерывании, тоже проверяется - между прерываниями ее мог
+ *	испортить основной цикл. Так проверяются обращения к шине, прерванные
+ *	на середине, и состояние шины (XMBK) после возврата из прерывания.
+ *
+ *	Обращения из прерывания не учитываются в TStat, их кол-во -
+ *	getCalls() * BUS_PER_CALL.
+ */
+class TBusStress {
+
+public:
+	/// Размер окна 2RAM, степень двойки.
+	static const uint16_t WINDOW = 256;
+
+	/// Обращений к шине в одном прерывании.
+	static const uint8_t BUS_PER_CALL = 5;
+
+	/**	Конструктор.
+	 *
+	 *	@param ramAdr Начало окна 2RAM.
+	 *	@param regAdr Адрес регистра ПЛИС записи/чтения.
+	 */
+	TBusStress(uint16_t ramAdr, uint16_t regAdr) :
+			ram(extPtr<EXT_REG(uint8_t)> (ramAdr)),
+			reg(extPtr<EXT_REG(uint8_t)> (regAdr)) {
+		active = false;
+		clear();
+	}
+
+	/**	Запуск нагрузки.
+	 *
+	 *	Счетчики обнуляются, первое прерывание через STRESS_PERIOD_US.
+	 */
+	void start() {
+		clear();
+		active = true;
+#if defined(__AVR__)
+		TCCR2 = 0;
+		TCNT2 = 0;
+		OCR2 = TIMER2_OCR;
+		TIFR = (1 << OCF2);
+		TIMSK |= (1 << OCIE2);
+		TCCR2 = (1 << WGM21) | TIMER2_CS;
+#else
+		simBoard.setTimer2(US_TO_CYCLES(STRESS_PERIOD_US));
+#endif
+	}
+
+	/**	Остановка нагрузки.
+	 *
+	 *	В регистр ПЛИС записывается 0.
+	 */
+	void stop() {
+#if defined(__AVR__)
+		TIMSK &= ~(1 << OCIE2);
+		TCCR2 = 0;
+#else
+		simBoard.setTimer2(0);
+#endif
+		active = false;
+		TStat::write(*reg, 0);
+	}
+
+	/**	Обращения к шине по прерыванию Timer2.
+	 *
+	 *	Вызывается из прерывания TIMER2_COMP_vect.
+	 */
+	void isr() {
+		if (!active)
+			return;
+
+		// в первом прерывании предыдущей ячейки нет, но чтение то же
+		uint8_t prev = ram[(pos - 1) & (WINDOW - 1)];
+		if ((calls != 0) && (prev != val)) {
+			ramErrors++;
+		}
+
+		val += STEP;
+		ram[pos] = val;
+		if (ram[pos] != val) {
+			ramErrors++;
+		}
+		*reg = val;
+		if (*reg != val) {
+			regErrors++;
+		}
+
+		pos = (pos + 1) & (WINDOW - 1);
+		calls++;
+	}
+
+	/// Кол-во прерываний с последнего запуска.
+	uint32_t getCalls() const { return calls; }
+
+	/// Кол-во ошибок 2RAM с последнего запуска.
+	uint16_t getRamErrors() const { return ramErrors; }
+
+	/// Кол-во ошибок регистра ПЛИС с последнего запуска.
+	uint16_t getRegErrors() const { return regErrors; }
+
+private:
+	/// Шаг последовательности, нечетный - проходятся все значения.
+	static const uint8_t STEP = 0x3B;
+
+	volatile EXT_REG(uint8_t) * const ram;	///< Окно 2RAM.
+	volatile EXT_REG(uint8_t) * const reg;	///< Регистр ПЛИС.
+	volatile bool active;					///< Нагрузка запущена.
+	uint16_t pos;							///< Ячейка окна.
+	uint8_t val;							///< Последнее значение.
+	uint32_t calls;							///< Кол-во прерываний.
+	uint16_t ramErrors;						///< Ошибки 2RAM.
+	uint16_t regErrors;						///< Ошибки регистра ПЛИС.
+
+	/**	Обнуление счетчиков.
+	 *
+	 */
+	void clear() {
+		pos = 0;
+		val = 0;
+		calls = 0;
+		ramErrors = 0;
+		regErrors = 0;
+	}
+};
+
+#endif /* TBUSSTRESS_H_ */
@@ -0,0 +1,94 @@
+/*
+ * TCrc.h
+ *
+ *	Вычисление контрольных сумм.
+ */
+
+#ifndef TCRC_H_
+#define TCRC_H_
+
+#include <avr/pgmspace.h>
+#include <stdint.h>
+
+/**	\brief Контрольные суммы по таблицам во flash.
+ *
+ *	CRC-16 и CRC-32 считаются по таблицам на байт (512 и 1024 байт flash)
+ *	или на полубайт (32 и 64 байта flash, но два чтения таблицы на байт).
+ *	При заданном CRC_NIBBLE_ONLY таблицы на байт не собираются.
+ */
+class TCrc {
+
+public:
+	/// Массив значений для вычисления CRC-8.
+	static const uint8_t crc8[256];
+
+	/**	Добавление байта к CRC-8.
+	 *
+	 *	@param crc Текущее значение CRC.
+	 *	@param val Байт данных.
+	 *	@return Новое значение CRC.
+	 */
+	static uint8_t getCrc8(uint8_t crc, uint8_t val) {
+		return pgm_read_byte(&crc8[crc ^ val]);
+	}
+
+#if !defined(CRC_NIBBLE_ONLY)
+	/// Массив значений для вычисления CRC-16/CCITT.
+	static const uint16_t crc16[256];
+
+	/// Массив значений для вычисления CRC-32.
+	static const uint32_t crc32[256];
+
+	/**	Добавление байта к CRC-16/CCITT.
+	 *
+	 *	@param crc Текущее значение CRC.
+	 *	@param val Байт данных.
+	 *	@return Новое значение CRC.
+	 */
+	static uint16_t getCrc16(uint16_t crc, uint8_t val) {
+		return (crc << 8) ^ pgm_read_word(&crc16[(crc >> 8) ^ val]);
+	}
+
+	/**	Добавление байта к CRC-32.
+	 *
+	 *	@param crc Текущее значение CRC.
+	 *	@param val Байт данных.
+	 *	@return Новое значение CRC.
+	 */
+	static uint32_t getCrc32(uint32_t crc, uint8_t val) {
+		return (crc >> 8) ^ pgm_read_dword(&crc32[(crc ^ val) & 0xFF]);
+	}
+#endif
+
+	/// Массив значений для вычисления CRC-16/CCITT по полубайтам.
+	static const uint16_t crc16n[16];
+
+	/// Массив значений для вычисления CRC-32 по полубайтам.
+	static const uint32_t crc32n[16];
+
+	/**	Добавление байта к CRC-16/CCITT, по полубайтам.
+	 *
+	 *	@param crc Текущее значение CRC.
+	 *	@param val Байт данных.
+	 *	@return Новое значение CRC.
+	 */
+	static uint16_t getCrc16Nibble(uint16_t crc, uint8_t val) {
+		crc = (crc << 4) ^ pgm_read_word(&crc16n[(crc >> 12) ^ (val >> 4)]);
+		crc = (crc << 4) ^ pgm_read_word(&crc16n[(crc >> 12) ^ (val & 0x0F)]);
+		return crc;
+	}
+
+	/**	Добавление байта к CRC-32, по полубайтам.
+	 *
+	 *	@param crc Текущее значение CRC.
+	 *	@param val Байт данных.
+	 *	@return Новое значение CRC.
+	 */
+	static uint32_t getCrc32Nibble(uint32_t crc, uint8_t val) {
+		crc = (crc >> 4) ^ pgm_read_dword(&crc32n[(crc ^ val) & 0x0F]);
+		crc = (crc >> 4) ^ pgm_read_dword(&crc32n[(crc ^ (val >> 4)) & 0x0F]);
+		return crc;
+	}
+};
+
+#endif /* TCRC_H_ */
@@ -0,0 +1,48 @@
+/*
+ * TExtBus.h
+ *
+ *	Доступ к устройствам на внешней шине МК (ПЛИС, 2RAM, FRAM).
+ *
+ *	Для МК регистры внешних устройств - это обычные ячейки памяти, поэтому
+ *	обращение к ним компилируется в прямые команды LD/ST. При сборке на ПК
+ *	(каталог host) вместо них подставляется модель платы, которая хранит
+ *	содержимое устройств и подсчитывает обращения к шине.
+ */
+
+#ifndef TEXTBUS_H_
+#define TEXTBUS_H_
+
+#include <stdint.h>
+
+#if defined(__AVR__)
+
+/// Тип регистра (ячейки памяти) расположенного на внешней шине.
+#define EXT_REG(type) type
+
+/**	Указатель на структуру расположенную во внешней памяти.
+ *
+ *	@param adr Адрес на внешней шине.
+ *	@return Указатель на структуру.
+ */
+template <typename T>
+inline volatile T* extPtr(uint16_t adr) {
+	return reinterpret_cast<volatile T*> (adr);
+}
+
+/**	Адрес на внешней шине для указателя на регистр (ячейку памяти).
+ *
+ *	@param p Указатель.
+ *	@return Адрес.
+ */
+inline uint16_t extAdr(const volatile void *p) {
+	return reinterpret_cast<uint16_t> (p);
+}
+
+#else
+
+// модель платы БСП для сборки на ПК
+#include "TSimBoard.h"
+
+#endif
+
+#endif /* TEXTBUS_H_ */
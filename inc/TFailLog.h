@@ -0,0 +1,121 @@
+/*
+ * TFailLog.h
+ *
+ *	Запись адресов и разрядов ошибок тестов памяти и шин.
+ */
+
+#ifndef TFAILLOG_H_
+#define TFAILLOG_H_
+
+#include <stdint.h>
+
+/// Кол-во записей ошибок подряд идущих адресов (TFailLog).
+#ifndef FAIL_RUN_MAX
+#define FAIL_RUN_MAX 8
+#endif
+
+/**	\brief Запись ошибок теста с объединением подряд идущих адресов.
+ *
+ *	Ошибки одного адреса и соседних адресов (в любом направлении обхода)
+ *	объединяются в одну запись SRun, разряды ошибок объединяются по ИЛИ.
+ *	Записей не больше FAIL_RUN_MAX, ошибки сверх них учитываются только в
+ *	общем кол-ве и общей маске разрядов.
+ *
+ *	add() вызывается только при обнаружении ошибки, поэтому на проходе
+ *	без ошибок запись ничего не стоит. По записям видно, отказал ли
+ *	отдельный адрес (микросхема) или разряд на всей области (линия).
+ */
+class TFailLog {
+
+public:
+	/// Ошибки подряд идущих адресов
+	struct SRun {
+		uint16_t adr;		///< Начальный адрес.
+		uint16_t len;		///< Кол-во адресов.
+		uint8_t mask;		///< Ошибочные разряды.
+	};
+
+	/**	Конструктор.
+	 *
+	 */
+	TFailLog() {
+		clear();
+	}
+
+	/**	Очистка записи.
+	 *
+	 */
+	void clear() {
+		num = 0;
+		fails = 0;
+		lost = 0;
+		mask = 0;
+	}
+
+	/**	Запись ошибки.
+	 *
+	 *	@param adr Адрес.
+	 *	@param bits Ошибочные разряды.
+	 */
+	void add(uint16_t adr, uint8_t bits) {
+		mask |= bits;
+		if (fails != 0xFFFF) {
+			fails++;
+		}
+
+		if (num != 0) {
+			SRun &r = run[num - 1];
+
+			if (static_cast<uint16_t> (adr - r.adr) < r.len) {
+				r.mask |= bits;
+				return;
+			}
+
+			if (static_cast<uint16_t> (adr - r.adr) == r.len) {
+				r.len++;
+				r.mask |= bits;
+				return;
+			}
+
+			if (static_cast<uint16_t> (adr + 1) == r.adr) {
+				r.adr = adr;
+				r.len++;
+				r.mask |= bits;
+				return;
+			}
+		}
+
+		if (num < FAIL_RUN_MAX) {
+			run[num].adr = adr;
+			run[num].len = 1;
+			run[num].mask = bits;
+			num++;
+		} else if (lost != 0xFFFF) {
+			lost++;
+		}
+	}
+
+	/// Кол-во записей.
+	uint8_t getNum() const { return num; }
+
+	/// Запись \a i.
+	const SRun& getRun(uint8_t i) const { return run[i]; }
+
+	/// Кол-во ошибок (до 0xFFFF).
+	uint16_t getFails() const { return fails; }
+
+	/// Кол-во ошибок, не поместившихся в записи (до 0xFFFF).
+	uint16_t getLost() const { return lost; }
+
+	/// Ошибочные разряды всех ошибок.
+	uint8_t getMask() const { return mask; }
+
+private:
+	SRun run[FAIL_RUN_MAX];		///< Записи.
+	uint8_t num;				///< Кол-во записей.
+	uint16_t fails;				///< Кол-во ошибок.
+	uint16_t lost;				///< Ошибок вне записей.
+	uint8_t mask;				///< Разряды всех ошибок.
+};
+
+#endif /* TFAILLOG_H_ */
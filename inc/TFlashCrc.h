@@ -0,0 +1,119 @@
+/*
+ * TFlashCrc.h
+ *
+ *	Проверка целостности программы во flash МК.
+ */
+
+#ifndef TFLASHCRC_H_
+#define TFLASHCRC_H_
+
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include "TSignature.h"
+
+/**	\brief Проверка целостности программы во flash МК по CRC-32.
+ *
+ *	В программу собирается запись STAMP (SStamp) с признаком MAGIC и
+ *	незаполненными длиной образа и CRC (0xFFFFFFFF). После сборки
+ *	программа host/crcstamp находит запись в .hex по признаку и записывает
+ *	в нее длину образа (от адреса 0 до последнего байта .text и .data) и
+ *	CRC-32 образа, без поля \a crc самой записи.
+ *
+ *	При запуске CRC-32 (zlib) flash считается по таблице на байт
+ *	(TCrc::crc32), flash читается по 4 байта pgm_read_dword(). Расчет
+ *	разбит на блоки next(), между которыми вызывающий сбрасывает внешний
+ *	сторожевой таймер. Образ должен помещаться в первые 64 КБ flash
+ *	(pgm_read_* без _far).
+ */
+class TFlashCrc {
+
+public:
+	/// Запись длины и CRC образа (хранится во flash).
+	struct SStamp {
+		uint32_t magic;		///< Признак записи, MAGIC.
+		uint32_t len;		///< Длина образа, 0xFFFFFFFF - не заполнена.
+		uint32_t crc;		///< CRC-32 образа без этого поля.
+	};
+
+	/// Признак записи ("FCRC" в порядке байт flash).
+	static const uint32_t MAGIC = 0x43524346UL;
+
+	/// Запись длины и CRC образа.
+	static const SStamp STAMP;
+
+	/// Результат проверки
+	enum RESULT {
+		RESULT_OK			= 0,	///< CRC совпала.
+		RESULT_UNSTAMPED	= 1,	///< Запись не заполнена, CRC не считалась.
+		RESULT_BAD			= 2		///< CRC или длина образа неверны.
+	};
+
+	TFlashCrc() : adr(0), field(0), len(0), crc(0), result(RESULT_UNSTAMPED) {}
+
+	/**	Начало проверки, чтение записи STAMP.
+	 *
+	 *	@return False - CRC считать не нужно, результат уже известен
+	 *	(getResult()).
+	 */
+	bool begin();
+
+	/**	Расчет CRC следующего блока flash.
+	 *
+	 *	@param block Размер блока, байт.
+	 *	@return True - образ пройден, результат получен (getResult()).
+	 */
+	bool next(uint16_t block);
+
+	/// Результат проверки (RESULT).
+	uint8_t getResult() const { return result; }
+
+	/// Длина образа из записи.
+	uint32_t getLen() const { return len; }
+
+	/// Вычисленная CRC-32, до окончания расчета - 0.
+	uint32_t getCrc() const { return crc; }
+
+private:
+#if defined(CRC_NIBBLE_ONLY)
+	typedef TSigCrc32Nibble TSig;	///< CRC-32 по таблице на полубайт.
+#else
+	typedef TSigCrc32 TSig;			///< CRC-32 по таблице на байт.
+#endif
+
+	TSig sig;			///< CRC пройденной части образа.
+	uint32_t adr;		///< Следующий адрес flash.
+	uint32_t field;		///< Адрес поля \a crc записи.
+	uint32_t len;		///< Длина образа из записи.
+	uint32_t crc;		///< Вычисленная CRC.
+	uint8_t result;		///< Результат проверки.
+
+	// Добавление к CRC области flash.
+	void add(uint16_t from, uint16_t n);
+
+	/**	Указатель на байт flash.
+	 *
+	 *	@param adr Адрес flash.
+	 *	@return Указатель для pgm_read_*.
+	 */
+	static const void* getPtr(uint16_t adr) {
+#if defined(__AVR__)
+		return reinterpret_cast<const void*> (adr);
+#else
+		return &simBoard.flash[adr];
+#endif
+	}
+
+	/**	Адрес записи STAMP во flash.
+	 *
+	 *	@return Адрес flash.
+	 */
+	static uint16_t getStampAdr() {
+#if defined(__AVR__)
+		return reinterpret_cast<uint16_t> (&STAMP);
+#else
+		return simBoard.flashStamp;
+#endif
+	}
+};
+
+#endif /* TFLASHCRC_H_ */
@@ -0,0 +1,94 @@
+/*
+ * TLineTest.h
+ *
+ *	Проверка линий данных и адреса области внешней памяти.
+ */
+
+#ifndef TLINETEST_H_
+#define TLINETEST_H_
+
+#include <stdint.h>
+#include "TExtBus.h"
+#include "TStat.h"
+
+/**	\brief Проверка линий данных и адреса области внешней памяти.
+ *
+ *	Быстрая проверка перед полным тестом памяти: обращения только по
+ *	адресам ADR и ADR + (1 << k), т.е. O(log N). Неисправная линия
+ *	определяется точно, без прохода всей памяти.
+ *
+ *	Размер области \a SIZE должен быть степенью двойки.
+ */
+template <uint16_t ADR, uint16_t SIZE>
+class TLineTest {
+
+public:
+	/**	Проверка линий данных бегущими единицей и нулем.
+	 *
+	 *	@return Маска линий данных, залипших или замкнутых с соседними.
+	 */
+	static uint8_t dataLines() {
+		volatile EXT_REG(uint8_t) *p = extPtr<EXT_REG(uint8_t)> (ADR);
+		uint8_t fail = 0;
+
+		for(uint8_t bit = 1; bit != 0; bit <<= 1) {
+			TStat::write(*p, bit);
+			fail |= TStat::read(*p) ^ bit;
+			TStat::write(*p, ~bit);
+			fail |= TStat::read(*p) ^ static_cast<uint8_t> (~bit);
+		}
+
+		return fail;
+	}
+
+	/**	Проверка линий адреса.
+	 *
+	 *	По адресам со смещением (1 << k) и в начало области записывается
+	 *	0xAA. Затем 0x55 записывается в начало области и по очереди по
+	 *	каждому смещению, остальные ячейки при этом не должны измениться.
+	 *	Проверку имеет смысл проводить только при исправных линиях данных.
+	 *
+	 *	@return Маска линий адреса, залипших или замкнутых между собой.
+	 */
+	static uint16_t adrLines() {
+		static const uint8_t PAT = 0xAA;
+		static const uint8_t ANTI = 0x55;
+		volatile EXT_REG(uint8_t) *p = extPtr<EXT_REG(uint8_t)> (ADR);
+		uint16_t fail = 0;
+
+		for(uint16_t off = 1; off < SIZE; off <<= 1) {
+			TStat::write(p[off], PAT);
+		}
+		TStat::write(p[0], PAT);
+
+		// линия залипла в 1: ячейка совпадает с началом области
+		TStat::write(p[0], ANTI);
+		for(uint16_t off = 1; off < SIZE; off <<= 1) {
+			if (TStat::read(p[off]) != PAT) {
+				fail |= off;
+			}
+		}
+		TStat::write(p[0], PAT);
+
+		// линия залипла в 0 или замкнута с другой
+		for(uint16_t off = 1; off < SIZE; off <<= 1) {
+			TStat::write(p[off], ANTI);
+
+			if (TStat::read(p[0]) != PAT) {
+				fail |= off;
+			}
+
+			for(uint16_t tmp = 1; tmp < SIZE; tmp <<= 1) {
+				if ((tmp != off) && (TStat::read(p[tmp]) != PAT)) {
+					fail |= off | tmp;
+				}
+			}
+
+			TStat::write(p[off], PAT);
+		}
+
+		return fail;
+	}
+};
+
+#endif /* TLINETEST_H_ */
@@ -0,0 +1,256 @@
+/*
+ * TMarch.h
+ *
+ *	March-тесты области внешней памяти.
+ */
+
+#ifndef TMARCH_H_
+#define TMARCH_H_
+
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include "TExtBus.h"
+#include "TTiming.h"
+#include "TStat.h"
+#include "TFailLog.h"
+
+/// Алгоритмы March-тестов
+enum MARCH {
+	MARCH_MATS_PLUS	= 0,	///< MATS+, 5N: залипания, дешифратор адреса.
+	MARCH_C_MINUS	= 1,	///< March C-, 10N: + связность ячеек.
+	MARCH_B			= 2,	///< March B, 17N: + связанные неисправности.
+	MARCH_MAX				///< Кол-во алгоритмов.
+};
+
+/**	\brief Элемент March-теста.
+ *
+ *	Последовательность операций, выполняемая над каждой ячейкой в порядке
+ *	увеличения или уменьшения адреса.
+ */
+struct SMarchElement {
+	/// Операции над ячейкой
+	enum OP {
+		OP_R0 = 0,		///< Чтение, ожидается фон.
+		OP_R1 = 1,		///< Чтение, ожидается инверсный фон.
+		OP_W0 = 2,		///< Запись фона.
+		OP_W1 = 3		///< Запись инверсного фона.
+	};
+
+	/// Направление обхода ячеек
+	enum DIR {
+		DIR_UP		= 0,	///< По возрастанию адреса (или любой порядок).
+		DIR_DOWN	= 1,	///< По убыванию адреса.
+		DIR_END		= 2		///< Конец алгоритма.
+	};
+
+	/// Максимальное кол-во операций в элементе.
+	static const uint8_t OP_MAX = 6;
+
+	uint8_t dir;			///< Направление обхода.
+	uint8_t num;			///< Кол-во операций.
+	uint8_t op[OP_MAX];		///< Операции.
+};
+
+/// Таблицы элементов March-тестов (см. TMarch.cpp).
+extern const SMarchElement marchMatsPlus[];
+extern const SMarchElement marchCMinus[];
+extern const SMarchElement marchB[];
+
+/**	\brief March-тест области внешней памяти.
+ *
+ *	Область задается начальным адресом \a ADR и размером \a SIZE на этапе
+ *	компиляции. Внешний сторожевой таймер сбрасывается чтением по адресу
+ *	\a WDT_ADR после каждого блока ячеек.
+ *
+ *	Вместо 0 и 1 используется фон \a bg и его инверсия, для обнаружения
+ *	связности разрядов внутри байта тест повторяется с фонами 0x00, 0x55,
+ *	0x33, 0x0F.
+ *
+ *	Элементы из одной или двух операций (w, r, r-w) выполняются
+ *	отдельными циклами с инкрементом указателя, остальные - общим циклом.
+ *	Ошибка записывается в TFailLog отдельным вызовом, так что цикл без
+ *	ошибок не дороже простого сравнения. Элемент с ошибкой выполняется до
+ *	конца, чтобы записать все ошибочные адреса, после него тест
+ *	останавливается.
+ */
+template <uint16_t ADR, uint16_t SIZE, uint16_t WDT_ADR>
+class TMarch {
+
+public:
+	/**	Выполнение March-теста.
+	 *
+	 *	Тест прекращается после элемента, в котором обнаружена ошибка.
+	 *
+	 *	@param alg Алгоритм.
+	 *	@param bg Фон.
+	 *	@param log Запись ошибок.
+	 *	@return Адрес первой ошибки, 0 - ошибок нет.
+	 */
+	static uint16_t run(MARCH alg, uint8_t bg, TFailLog &log) {
+		const SMarchElement *el = marchCMinus;
+		uint16_t fail = 0;
+
+		if (alg == MARCH_MATS_PLUS) {
+			el = marchMatsPlus;
+		} else if (alg == MARCH_B) {
+			el = marchB;
+		}
+
+		for(; fail == 0; el++) {
+			SMarchElement e;
+			memcpy_P(&e, el, sizeof(e));
+
+			if (e.dir == SMarchElement::DIR_END)
+				break;
+
+			fail = element(e, bg, log);
+		}
+
+		return fail;
+	}
+
+private:
+	/// Выполнение элемента March-теста, возвращает адрес первой ошибки
+	/// или 0.
+	static uint16_t element(const SMarchElement &e, uint8_t bg,
+			TFailLog &log) {
+		uint16_t fail = 0;
+		bool down = (e.dir == SMarchElement::DIR_DOWN);
+		volatile EXT_REG(uint8_t) *p = extPtr<EXT_REG(uint8_t)> (ADR);
+		uint16_t block = EXT_WDT_BLOCK / e.num;
+
+		if (down) {
+			p += SIZE - 1;
+		}
+
+		for(uint16_t left = SIZE; left > 0; ) {
+			uint16_t n = (left > block) ? block : left;
+			left -= n;
+
+			uint16_t f = 0;
+			if (e.num == 1) {
+				if (e.op[0] & 2)
+					write(p, n, down, (e.op[0] & 1) ? ~bg : bg);
+				else
+					f = read(p, n, down, (e.op[0] & 1) ? ~bg : bg, log);
+			} else if ((e.num == 2) && !(e.op[0] & 2) && (e.op[1] & 2)) {
+				f = readWrite(p, n, down, (e.op[0] & 1) ? ~bg : bg,
+						(e.op[1] & 1) ? ~bg : bg, log);
+			} else {
+				f = ops(p, n, down, e, bg, log);
+			}
+
+			if (fail == 0) {
+				fail = f;
+			}
+
+			p += down ? -n : n;
+			wdt();
+
+			TStat::addBus(n * e.num);
+		}
+
+		return fail;
+	}
+
+	/// Запись значения в \a n ячеек.
+	static void write(volatile EXT_REG(uint8_t) *p, uint16_t n, bool down,
+			uint8_t w) {
+		if (down) {
+			do { *p-- = w; } while(--n);
+		} else {
+			do { *p++ = w; } while(--n);
+		}
+	}
+
+	/// Проверка значения \a n ячеек, возвращает адрес первой ошибки или 0.
+	static uint16_t read(volatile EXT_REG(uint8_t) *p, uint16_t n, bool down,
+			uint8_t r, TFailLog &log) {
+		uint16_t fail = 0;
+
+		if (down) {
+			do {
+				uint8_t v = *p;
+				if (v != r)
+					fail = miss(p, v ^ r, fail, log);
+				p--;
+			} while(--n);
+		} else {
+			do {
+				uint8_t v = *p;
+				if (v != r)
+					fail = miss(p, v ^ r, fail, log);
+				p++;
+			} while(--n);
+		}
+
+		return fail;
+	}
+
+	/// Проверка значения и запись нового в \a n ячеек, возвращает адрес
+	/// первой ошибки или 0.
+	static uint16_t readWrite(volatile EXT_REG(uint8_t) *p, uint16_t n,
+			bool down, uint8_t r, uint8_t w, TFailLog &log) {
+		int8_t inc = down ? -1 : 1;
+		uint16_t fail = 0;
+
+		do {
+			uint8_t v = *p;
+			if (v != r)
+				fail = miss(p, v ^ r, fail, log);
+			*p = w;
+			p += inc;
+		} while(--n);
+
+		return fail;
+	}
+
+	/// Выполнение произвольной последовательности операций в \a n ячейках,
+	/// возвращает адрес первой ошибки или 0.
+	static uint16_t ops(volatile EXT_REG(uint8_t) *p, uint16_t n, bool down,
+			const SMarchElement &e, uint8_t bg, TFailLog &log) {
+		int8_t inc = down ? -1 : 1;
+		uint16_t fail = 0;
+
+		do {
+			for(uint8_t i = 0; i < e.num; i++) {
+				uint8_t op = e.op[i];
+				uint8_t val = (op & 1) ? ~bg : bg;
+
+				if (op & 2) {
+					*p = val;
+				} else {
+					uint8_t v = *p;
+					if (v != val)
+						fail = miss(p, v ^ val, fail, log);
+				}
+			}
+			p += inc;
+		} while(--n);
+
+		return fail;
+	}
+
+	/**	Запись ошибки ячейки.
+	 *
+	 *	@param p Указатель на ячейку.
+	 *	@param bits Ошибочные разряды.
+	 *	@param fail Адрес первой ошибки или 0.
+	 *	@param log Запись ошибок.
+	 *	@return Адрес первой ошибки.
+	 */
+	static uint16_t miss(volatile EXT_REG(uint8_t) *p, uint8_t bits,
+			uint16_t fail, TFailLog &log) {
+		uint16_t adr = extAdr(p);
+
+		log.add(adr, bits);
+		return (fail != 0) ? fail : adr;
+	}
+
+	/// Сброс внешнего сторожевого таймера.
+	static void wdt() {
+		TStat::read(*extPtr<EXT_REG(uint8_t)> (WDT_ADR));
+	}
+};
+
+#endif /* TMARCH_H_ */
@@ -0,0 +1,112 @@
+/*
+ * TPattern.h
+ *
+ *	Генераторы тестовых последовательностей для проверки памяти.
+ *
+ *	Все генераторы имеют одинаковый интерфейс: конструктор с начальным
+ *	значением \a seed и функцию next(), возвращающую следующие два байта
+ *	последовательности (младший байт пишется первым). Повторное создание
+ *	генератора с тем же \a seed дает ту же последовательность, это
+ *	используется при проверке записанной памяти.
+ */
+
+#ifndef TPATTERN_H_
+#define TPATTERN_H_
+
+#include <stdint.h>
+#include "TCrc.h"
+
+/**	\brief Псевдослучайная последовательность xorshift16 (7, 9, 8).
+ *
+ *	Период 65535 шагов (128 кБ), поэтому в FRAM и 2RAM не записывается
+ *	повторяющихся кусков. На каждом шаге получается два байта, обращения к
+ *	таблицам во flash не нужны, сдвиги на 7, 9 и 8 разрядов для AVR
+ *	сводятся к пересылкам байт и одиночным сдвигам.
+ */
+class TPatternXorshift {
+
+public:
+	TPatternXorshift(uint8_t seed) : x(0xACE1 ^ seed) {}
+
+	uint16_t next() {
+		x ^= x << 7;
+		x ^= x >> 9;
+		x ^= x << 8;
+		return x;
+	}
+
+private:
+	uint16_t x;		///< Текущее состояние (никогда не равно 0).
+};
+
+/**	\brief Последовательность на основе таблицы CRC-8.
+ *
+ *	Исходный генератор тестов FRAM/2RAM: каждый байт получается из
+ *	предыдущего чтением таблицы CRC-8 из flash, ^ i - надо для того, чтобы
+ *	в память не писались повторяющиеся куски кода. Оставлен для сравнения.
+ */
+class TPatternCrc8 {
+
+public:
+	TPatternCrc8(uint8_t seed) : val(seed), i(0) {}
+
+	uint16_t next() {
+		uint8_t lo = step();
+		uint8_t hi = step();
+		return (hi << 8) | lo;
+	}
+
+private:
+	uint8_t val;	///< Последнее значение.
+	uint8_t i;		///< Младший байт номера байта.
+
+	uint8_t step() {
+		val = TCrc::getCrc8(val, i++);
+		return val;
+	}
+};
+
+/**	\brief Бегущая единица.
+ *
+ *	В каждом байте установлен один разряд, номер разряда сдвигается на
+ *	каждом байте, начиная с \a seed.
+ */
+class TPatternWalking {
+
+public:
+	TPatternWalking(uint8_t seed) : val(1 << (seed % 8)) {}
+
+	uint16_t next() {
+		uint8_t lo = step();
+		uint8_t hi = step();
+		return (hi << 8) | lo;
+	}
+
+private:
+	uint8_t val;	///< Текущее значение.
+
+	uint8_t step() {
+		uint8_t tmp = val;
+		val = (val << 1) | (val >> 7);
+		return tmp;
+	}
+};
+
+/**	\brief Шахматный порядок 0x55/0xAA.
+ *
+ *	При нечетном \a seed последовательность инвертирована.
+ */
+class TPatternChecker {
+
+public:
+	TPatternChecker(uint8_t seed) : val((seed & 1) ? 0x55AA : 0xAA55) {}
+
+	uint16_t next() {
+		return val;
+	}
+
+private:
+	uint16_t val;	///< Значение двух байт.
+};
+
+#endif /* TPATTERN_H_ */
@@ -0,0 +1,207 @@
+/*
+ * TRegTest.h
+ *
+ *	Проверка регистров по таблице описания.
+ */
+
+#ifndef TREGTEST_H_
+#define TREGTEST_H_
+
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include "TExtBus.h"
+#include "TFailLog.h"
+#include "TStat.h"
+
+/**	\brief Проверка регистров во внешней памяти по таблице описания.
+ *
+ *	Регистры описываются таблицей во flash (SReg): смещение, разрядность,
+ *	маска разрядов доступных на запись/чтение и значение. Одна процедура
+ *	run() проверяет все регистры таблицы:
+ *	- регистры только чтения (mask == 0): значение \a value дважды
+ *	считывается подряд, запись в них не выполняется (побочное действие
+ *	записи по адресу только чтения не определено);
+ *	- регистры записи/чтения: бегущие единица и ноль по разрядам маски;
+ *	- адресация: во все байты регистров записи/чтения записываются
+ *	различные числа, затем все регистры считываются;
+ *	- в конце в регистры записи/чтения записывается значение \a value.
+ *
+ *	Ошибочные разряды записываются в \a log по адресу байта регистра.
+ */
+template <uint16_t ADR>
+class TRegTest {
+
+public:
+	/// Описание регистра (хранится во flash)
+	struct SReg {
+		uint8_t offset;		///< Смещение от начального адреса.
+		uint8_t width;		///< Кол-во байт, 0 - конец таблицы.
+		uint16_t mask;		///< Разряды записи/чтения, 0 - только чтение.
+		uint16_t value;		///< Значение только чтения / после проверки.
+	};
+
+	/// Ошибки проверки регистров
+	enum ERROR {
+		ERROR_READ_ONLY	= (1 << 0),	///< Регистр только чтения.
+		ERROR_WALK_ONE	= (1 << 1),	///< Бегущая единица.
+		ERROR_WALK_ZERO	= (1 << 2),	///< Бегущий ноль.
+		ERROR_ALIAS		= (1 << 3)	///< Адресация регистров.
+	};
+
+	/**	Проверка регистров.
+	 *
+	 *	@param regs Таблица регистров во flash.
+	 *	@param log Запись ошибок.
+	 *	@return Ошибки проверки (ERROR).
+	 */
+	static uint8_t run(const SReg *regs, TFailLog &log) {
+		uint8_t error = 0;
+		uint16_t bus = 0;
+		const SReg *r;
+
+		for(r = regs; pgm_read_byte(&r->width) != 0; r++) {
+			uint8_t off = pgm_read_byte(&r->offset);
+			uint8_t width = pgm_read_byte(&r->width);
+			uint16_t mask = pgm_read_word(&r->mask);
+
+			if (mask == 0) {
+				uint16_t val = pgm_read_word(&r->value);
+
+				error |= check(off, width, val, 0xFFFF, ERROR_READ_ONLY, log);
+				error |= check(off, width, val, 0xFFFF, ERROR_READ_ONLY, log);
+				bus += 2 * width;
+				continue;
+			}
+
+			for(uint8_t bit = 0; bit < width * 8; bit++) {
+				uint16_t one = static_cast<uint16_t> (1U << bit);
+
+				if ((mask & one) == 0)
+					continue;
+
+				write(off, width, one);
+				error |= check(off, width, one, mask, ERROR_WALK_ONE, log);
+				write(off, width, ~one);
+				error |= check(off, width, ~one, mask, ERROR_WALK_ZERO, log);
+				bus += 4 * width;
+			}
+		}
+
+		// адресация: в каждый байт свое число
+		for(r = regs; pgm_read_byte(&r->width) != 0; r++) {
+			uint8_t off = pgm_read_byte(&r->offset);
+			uint8_t width = pgm_read_byte(&r->width);
+
+			if (pgm_read_word(&r->mask) != 0) {
+				write(off, width, sign(off, width));
+				bus += width;
+			}
+		}
+
+		for(r = regs; pgm_read_byte(&r->width) != 0; r++) {
+			uint8_t off = pgm_read_byte(&r->offset);
+			uint8_t width = pgm_read_byte(&r->width);
+			uint16_t mask = pgm_read_word(&r->mask);
+
+			if (mask == 0) {
+				error |= check(off, width, pgm_read_word(&r->value), 0xFFFF,
+						ERROR_ALIAS, log);
+			} else {
+				error |= check(off, width, sign(off, width), mask,
+						ERROR_ALIAS, log);
+				write(off, width, pgm_read_word(&r->value));
+				bus += width;
+			}
+			bus += width;
+		}
+
+		TStat::addBus(bus);
+
+		return error;
+	}
+
+	/**	Запись в регистры записи/чтения значений из таблицы.
+	 *
+	 *	@param regs Таблица регистров во flash.
+	 */
+	static void reset(const SReg *regs) {
+		uint16_t bus = 0;
+
+		for(const SReg *r = regs; pgm_read_byte(&r->width) != 0; r++) {
+			uint8_t width = pgm_read_byte(&r->width);
+
+			if (pgm_read_word(&r->mask) != 0) {
+				write(pgm_read_byte(&r->offset), width,
+						pgm_read_word(&r->value));
+				bus += width;
+			}
+		}
+
+		TStat::addBus(bus);
+	}
+
+private:
+	/**	Число для проверки адресации.
+	 *
+	 *	@param off Смещение регистра.
+	 *	@param width Кол-во байт регистра.
+	 *	@return Для каждого байта инверсия (смещение * 0x11).
+	 */
+	static uint16_t sign(uint8_t off, uint8_t width) {
+		uint16_t val = static_cast<uint8_t> (~(off * 0x11));
+
+		if (width > 1) {
+			val |= static_cast<uint16_t> (
+					static_cast<uint8_t> (~((off + 1) * 0x11))) << 8;
+		}
+
+		return val;
+	}
+
+	/**	Запись регистра, старший байт первым (как avr-gcc для volatile).
+	 *
+	 *	@param off Смещение регистра.
+	 *	@param width Кол-во байт регистра.
+	 *	@param val Значение.
+	 */
+	static void write(uint8_t off, uint8_t width, uint16_t val) {
+		volatile EXT_REG(uint8_t) *p = extPtr<EXT_REG(uint8_t)> (ADR + off);
+
+		if (width > 1) {
+			p[1] = static_cast<uint8_t> (val >> 8);
+		}
+		p[0] = static_cast<uint8_t> (val);
+	}
+
+	/**	Чтение регистра и сравнение с ожидаемым значением.
+	 *
+	 *	@param off Смещение регистра.
+	 *	@param width Кол-во байт регистра.
+	 *	@param val Ожидаемое значение.
+	 *	@param mask Проверяемые разряды.
+	 *	@param err Ошибка при несовпадении.
+	 *	@param log Запись ошибок.
+	 *	@return \a err при несовпадении, иначе 0.
+	 */
+	static uint8_t check(uint8_t off, uint8_t width, uint16_t val,
+			uint16_t mask, uint8_t err, TFailLog &log) {
+		volatile EXT_REG(uint8_t) *p = extPtr<EXT_REG(uint8_t)> (ADR + off);
+		uint8_t fail = 0;
+
+		for(uint8_t i = 0; i < width; i++) {
+			uint8_t bits = (p[i] ^ static_cast<uint8_t> (val))
+					& static_cast<uint8_t> (mask);
+
+			if (bits != 0) {
+				log.add(ADR + off + i, bits);
+				fail = err;
+			}
+			val >>= 8;
+			mask >>= 8;
+		}
+
+		return fail;
+	}
+};
+
+#endif /* TREGTEST_H_ */
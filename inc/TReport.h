@@ -0,0 +1,349 @@
+/*
+ * TReport.h
+ *
+ *	Передача результатов тестов по USART1 в двоичном виде.
+ *
+ *	Формат кадра (многобайтные поля - младшим байтом вперед):
+ *	- SYNC (0xA5);
+ *	- LEN, кол-во байт данных;
+ *	- SEQ, номер кадра, увеличивается на 1 с каждым кадром;
+ *	- TYPE, тип кадра (TReport::TYPE);
+ *	- данные, LEN байт;
+ *	- CRC-8 (TCrc::getCrc8()) байт от LEN до конца данных, начальное
+ *	значение 0.
+ *
+ *	Данные кадров:
+ *	- TYPE_START: версия протокола (1 байт), TICK_MS (1 байт), F_CPU в МГц
+ *	(1 байт);
+ *	- TYPE_RESULT: номер теста (1 байт), код ошибки (1 байт), адрес ошибки
+ *	(2 байта, 0 - не определен), длительность теста в тиках (2 байта);
+ *	- TYPE_STAT: номер теста (1 байт), такты МК выполнения шагов (4 байта),
+ *	такты МК ожидания между шагами (4 байта), кол-во обращений к внешней
+ *	шине (4 байта);
+ *	- TYPE_SETTLE: таймаут ожидания BusR в тактах МК (2 байта), наибольшее
+ *	время установления BusR в тактах МК для разрядов 0..7 BusW (8 x 2 байта,
+ *	0 - разряд не изменялся, 0xFFFF - не установился);
+ *	- TYPE_RESET: причина сброса МК, значение MCUCSR (1 байт), тесты
+ *	продолжены с контрольной точки (1 байт, 0 - начаты сначала), тест,
+ *	кол-во выполненных шагов и код ошибки контрольной точки (по 1 байту),
+ *	кол-во продолжений подряд (1 байт);
+ *	- TYPE_FAIL: номер теста (1 байт), кол-во ошибок (2 байта), кол-во
+ *	ошибок вне записей (2 байта), разряды всех ошибок (1 байт), затем
+ *	записи TFailLog::SRun: начальный адрес (2 байта), кол-во адресов
+ *	(2 байта), разряды (1 байт);
+ *	- TYPE_SWEEP: текущее кол-во тактов ожидания внешней шины (1 байт),
+ *	кол-во делителей частоты N (1 байт), делители (N байт), кол-во
+ *	областей шины M (1 байт), затем для каждой области и делителя маска
+ *	тактов ожидания 0..3, при которых проверка прошла (M x N байт);
+ *	- TYPE_BENCH: область шины (1 байт, TTests::BUS_AREA), кол-во байт
+ *	замера (2 байта), кол-во видов обращений N (1 байт), время замера в
+ *	тактах МК для каждого вида TBusBench (N x 4 байта);
+ *	- TYPE_STRESS: время прохода FRAM без нагрузки и с нагрузкой на шину в
+ *	тактах МК (по 4 байта), кол-во прерываний нагрузки (4 байта), ошибки
+ *	2RAM и регистра ПЛИС в прерывании (по 2 байта);
+ *	- TYPE_POST: код ошибки самопроверки (1 байт, TTests::post()), время
+ *	самопроверки в тактах МК (4 байта), кол-во обращений к внешней шине
+ *	(4 байта);
+ *	- TYPE_FLASH: результат проверки CRC программы (1 байт,
+ *	TFlashCrc::RESULT), длина образа из записи (4 байта), вычисленная
+ *	CRC-32 (4 байта), время проверки в тактах МК (4 байта);
+ *	- TYPE_PLAN: план тестов - первый и последний тест итерации (по 1
+ *	байту), флаги (1 байт, TTests::PLAN_FLAG), кол-во итераций (2 байта,
+ *	0 - без ограничения), законченные итерации (4 байта, 0 - план принят),
+ *	итерации с ошибками (4 байта); последняя итерация - маска тестов с
+ *	ошибками (2 байта, бит - номер теста), длительность в тиках (4 байта),
+ *	кол-во обращений к внешней шине (4 байта).
+ *
+ *	В обратную сторону по USART1 принимаются кадры команд того же формата,
+ *	SEQ не проверяется, TYPE - TReport::CMD:
+ *	- CMD_PLAN: выбор плана тестов (TTests::setPlan()) - первый и
+ *	последний тест итерации (по 1 байту, первый TEST_ERROR - тесты FSM без
+ *	плана), кол-во итераций (2 байта), флаги (1 байт). В ответ передается
+ *	кадр TYPE_PLAN с действующим планом.
+ *
+ *	Расшифровка кадров на ПК - host/TReportDecoder.h, программа decoder.
+ */
+
+#ifndef TREPORT_H_
+#define TREPORT_H_
+
+#include <avr/io.h>
+#include <util/delay.h>
+#include <stdint.h>
+#include "TCrc.h"
+#include "TFailLog.h"
+#include "TTiming.h"
+
+/**	\brief Канал результатов тестов и команд по USART1.
+ *
+ *	USART1 настраивается в low_level_init() на скорость UART_BAUD, 8N1.
+ *	Байты команд складываются в буфер в прерывании USART1_RX_vect
+ *	(rxIsr()) и разбираются в receive() в основном цикле.
+ *	Передача ведется опросом флага UDRE1: кадр результата занимает 10 байт,
+ *	т.е. около 100 мкс при 1 Мбод, один раз на тест.
+ */
+class TReport {
+
+public:
+	/// Начальный байт кадра.
+	static const uint8_t SYNC = 0xA5;
+
+	/// Версия протокола.
+	static const uint8_t VERSION = 2;
+
+	/// Типы кадров
+	enum TYPE {
+		TYPE_START	= 0,	///< Запуск тестов.
+		TYPE_RESULT	= 1,	///< Результат теста.
+		TYPE_STAT	= 2,	///< Статистика теста.
+		TYPE_SETTLE	= 3,	///< Время установления шины BusR.
+		TYPE_RESET	= 4,	///< Причина сброса МК.
+		TYPE_FAIL	= 5,	///< Адреса и разряды ошибок теста.
+		TYPE_SWEEP	= 6,	///< Подбор тактов ожидания внешней шины.
+		TYPE_BENCH	= 7,	///< Пропускная способность внешней шины.
+		TYPE_STRESS	= 8,	///< Проверка FRAM при нагрузке на шину.
+		TYPE_POST	= 9,	///< Быстрая самопроверка при запуске.
+		TYPE_FLASH	= 10,	///< Проверка CRC программы во flash.
+		TYPE_PLAN	= 11	///< План тестов.
+	};
+
+	/// Типы кадров команд
+	enum CMD {
+		CMD_PLAN	= 0		///< Выбор плана тестов.
+	};
+
+	/// Наибольшее кол-во байт данных кадра команды.
+	static const uint8_t CMD_DATA_MAX = 8;
+
+	/// Размер буфера приема, степень двойки.
+	static const uint8_t RX_BUF_SIZE = 32;
+
+	/**	Конструктор.
+	 *
+	 */
+	TReport() {
+		seq = 0;
+		crc = 0;
+		rxHead = 0;
+		rxTail = 0;
+		rxPos = 0;
+		rxCrc = 0;
+		rxLen = 0;
+		rxType = 0;
+	}
+
+	/**	Кадр запуска тестов.
+	 *
+	 */
+	void sendStart();
+
+	/**	Кадр результата теста.
+	 *
+	 *	@param test Номер теста.
+	 *	@param error Код ошибки, 0 - ошибок нет.
+	 *	@param adr Адрес ошибки, 0 - не определен.
+	 *	@param ticks Длительность теста, в тиках таймера.
+	 */
+	void sendResult(uint8_t test, uint8_t error, uint16_t adr, uint16_t ticks);
+
+	/**	Кадр статистики теста.
+	 *
+	 *	@param test Номер теста.
+	 *	@param busy Такты МК выполнения шагов теста.
+	 *	@param wait Такты МК ожидания между шагами теста.
+	 *	@param bus Кол-во обращений к внешней шине.
+	 */
+	void sendStat(uint8_t test, uint32_t busy, uint32_t wait, uint32_t bus);
+
+	/**	Кадр времени установления шины BusR.
+	 *
+	 *	@param timeout Таймаут ожидания, тактов МК.
+	 *	@param settle Время установления разрядов 0..7, тактов МК.
+	 */
+	void sendSettle(uint16_t timeout, const uint16_t settle[8]);
+
+	/**	Кадр причины сброса МК.
+	 *
+	 *	@param cause Значение MCUCSR.
+	 *	@param resumed True - тесты продолжены с контрольной точки.
+	 *	@param test Тест контрольной точки.
+	 *	@param step Выполнено шагов теста.
+	 *	@param error Код ошибки теста.
+	 *	@param resumes Кол-во продолжений подряд.
+	 */
+	void sendReset(uint8_t cause, bool resumed, uint8_t test, uint8_t step,
+			uint8_t error, uint8_t resumes);
+
+	/**	Кадр адресов и разрядов ошибок теста.
+	 *
+	 *	@param test Номер теста.
+	 *	@param log Запись ошибок.
+	 */
+	void sendFail(uint8_t test, const TFailLog &log);
+
+	/**	Кадр подбора тактов ожидания внешней шины.
+	 *
+	 *	@param wait Текущее кол-во тактов ожидания.
+	 *	@param div Делители частоты МК.
+	 *	@param divs Кол-во делителей.
+	 *	@param pass Маски тактов ожидания, [область][делитель].
+	 *	@param areas Кол-во областей.
+	 */
+	void sendSweep(uint8_t wait, const uint8_t *div, uint8_t divs,
+			const uint8_t *pass, uint8_t areas);
+
+	/**	Кадр пропускной способности внешней шины.
+	 *
+	 *	@param area Область шины.
+	 *	@param bytes Кол-во байт замера.
+	 *	@param cycles Время замера для каждого вида обращений, тактов МК.
+	 *	@param kinds Кол-во видов обращений.
+	 */
+	void sendBench(uint8_t area, uint16_t bytes, const uint32_t *cycles,
+			uint8_t kinds);
+
+	/**	Кадр проверки FRAM при нагрузке на шину.
+	 *
+	 *	@param quiet Время прохода без нагрузки, тактов МК.
+	 *	@param loaded Время прохода с нагрузкой, тактов МК.
+	 *	@param calls Кол-во прерываний нагрузки.
+	 *	@param ramErrors Ошибки 2RAM в прерывании.
+	 *	@param regErrors Ошибки регистра ПЛИС в прерывании.
+	 */
+	void sendStress(uint32_t quiet, uint32_t loaded, uint32_t calls,
+			uint16_t ramErrors, uint16_t regErrors);
+
+	/**	Кадр быстрой самопроверки при запуске.
+	 *
+	 *	@param error Код ошибки.
+	 *	@param cycles Время самопроверки, тактов МК.
+	 *	@param bus Кол-во обращений к внешней шине.
+	 */
+	void sendPost(uint8_t error, uint32_t cycles, uint32_t bus);
+
+	/**	Кадр проверки CRC программы во flash.
+	 *
+	 *	@param result Результат проверки (TFlashCrc::RESULT).
+	 *	@param len Длина образа из записи.
+	 *	@param crc Вычисленная CRC-32.
+	 *	@param cycles Время проверки, тактов МК.
+	 */
+	void sendFlash(uint8_t result, uint32_t len, uint32_t crc,
+			uint32_t cycles);
+
+	/**	Кадр плана тестов.
+	 *
+	 *	@param first Первый тест итерации.
+	 *	@param last Последний тест итерации.
+	 *	@param flags Флаги плана.
+	 *	@param count Кол-во итераций, 0 - без ограничения.
+	 *	@param iter Законченные итерации.
+	 *	@param failed Итерации с ошибками.
+	 *	@param mask Тесты с ошибками в последней итерации.
+	 *	@param ticks Длительность последней итерации, в тиках таймера.
+	 *	@param bus Обращения к внешней шине в последней итерации.
+	 */
+	void sendPlan(uint8_t first, uint8_t last, uint8_t flags, uint16_t count,
+			uint32_t iter, uint32_t failed, uint16_t mask, uint32_t ticks,
+			uint32_t bus);
+
+	/**	Байт принят USART1.
+	 *
+	 *	Вызывается из прерывания USART1_RX_vect. При переполнении буфера
+	 *	байт теряется, кадр команды не пройдет проверку CRC.
+	 */
+	void rxIsr() {
+		uint8_t val = UDR1;
+		uint8_t next = (rxHead + 1) & (RX_BUF_SIZE - 1);
+
+		if (next != rxTail) {
+			rxBuf[rxHead] = val;
+			rxHead = next;
+		}
+	}
+
+	/**	Прием кадра команды.
+	 *
+	 *	Разбираются уже принятые байты, без ожидания. Кадры с неверной CRC
+	 *	или с длиной больше CMD_DATA_MAX пропускаются.
+	 *
+	 *	@return True - принят кадр команды (getCmdType(), getCmdData()).
+	 */
+	bool receive();
+
+	/// Тип принятой команды (CMD).
+	uint8_t getCmdType() const { return rxType; }
+
+	/// Кол-во байт данных принятой команды.
+	uint8_t getCmdLen() const { return rxLen; }
+
+	/// Данные принятой команды.
+	const uint8_t* getCmdData() const { return rxData; }
+
+	/**	Ожидание окончания передачи.
+	 *
+	 *	После освобождения UDR1 в сдвиговом регистре остается не больше
+	 *	одного байта. Его передача ждется по времени, флаг TXC1 не
+	 *	используется, т.к. при передаче опросом он не сбрасывается.
+	 */
+	static void flush() {
+		while(!(UCSR1A & (1 << UDRE1)));
+		_delay_us(UART_BYTE_US);
+	}
+
+private:
+	uint8_t seq;		///< Номер следующего кадра.
+	uint8_t crc;		///< CRC передаваемого кадра.
+	uint8_t rxBuf[RX_BUF_SIZE];	///< Буфер приема.
+	volatile uint8_t rxHead;	///< Позиция записи в буфер приема.
+	volatile uint8_t rxTail;	///< Позиция чтения из буфера приема.
+	uint8_t rxPos;		///< Принято байт кадра команды, 0 - ждем SYNC.
+	uint8_t rxCrc;		///< CRC принимаемого кадра команды.
+	uint8_t rxLen;		///< Кол-во байт данных кадра команды.
+	uint8_t rxType;		///< Тип кадра команды.
+	uint8_t rxData[CMD_DATA_MAX];	///< Данные кадра команды.
+
+	// Начало кадра.
+	void begin(TYPE type, uint8_t len);
+
+	// Конец кадра.
+	void end();
+
+	/**	Передача байта кадра с добавлением к CRC.
+	 *
+	 *	@param val Байт.
+	 */
+	void put(uint8_t val) {
+		crc = TCrc::getCrc8(crc, val);
+		send(val);
+	}
+
+	/**	Передача двух байт кадра, младшим вперед.
+	 *
+	 *	@param val Значение.
+	 */
+	void put16(uint16_t val) {
+		put(val);
+		put(val >> 8);
+	}
+
+	/**	Передача четырех байт кадра, младшим вперед.
+	 *
+	 *	@param val Значение.
+	 */
+	void put32(uint32_t val) {
+		put16(val);
+		put16(val >> 16);
+	}
+
+	/**	Передача байта по USART1.
+	 *
+	 *	@param val Байт.
+	 */
+	static void send(uint8_t val) {
+		while(!(UCSR1A & (1 << UDRE1)));
+		UDR1 = val;
+	}
+};
+
+#endif /* TREPORT_H_ */
@@ -0,0 +1,127 @@
+/*
+ * TSignature.h
+ *
+ *	Сигнатуры для проверки памяти без побайтного сравнения.
+ *
+ *	Все сигнатуры имеют одинаковый интерфейс: конструктор без параметров,
+ *	add() для добавления очередного байта и get(), возвращающую значение
+ *	сигнатуры. Сигнатура записанной последовательности считается при
+ *	записи, затем сравнивается с сигнатурой прочитанной памяти.
+ */
+
+#ifndef TSIGNATURE_H_
+#define TSIGNATURE_H_
+
+#include <stdint.h>
+#include "TCrc.h"
+
+/**	\brief Без сигнатуры, память проверяется побайтным сравнением.
+ *
+ *	Все функции пустые и при компиляции исчезают.
+ */
+class TSigNone {
+
+public:
+	/// Сигнатура используется.
+	static const bool ENABLED = false;
+
+	void add(uint8_t) {}
+
+	uint32_t get() const {
+		return 0;
+	}
+};
+
+#if !defined(CRC_NIBBLE_ONLY)
+
+/**	\brief CRC-16/CCITT по таблице на байт.
+ *
+ */
+class TSigCrc16 {
+
+public:
+	static const bool ENABLED = true;
+
+	TSigCrc16() : crc(0xFFFF) {}
+
+	void add(uint8_t val) {
+		crc = TCrc::getCrc16(crc, val);
+	}
+
+	uint32_t get() const {
+		return crc;
+	}
+
+private:
+	uint16_t crc;	///< Текущее значение CRC.
+};
+
+/**	\brief CRC-32 по таблице на байт.
+ *
+ */
+class TSigCrc32 {
+
+public:
+	static const bool ENABLED = true;
+
+	TSigCrc32() : crc(0xFFFFFFFF) {}
+
+	void add(uint8_t val) {
+		crc = TCrc::getCrc32(crc, val);
+	}
+
+	uint32_t get() const {
+		return ~crc;
+	}
+
+private:
+	uint32_t crc;	///< Текущее значение CRC.
+};
+
+#endif
+
+/**	\brief CRC-16/CCITT по таблице на полубайт.
+ *
+ */
+class TSigCrc16Nibble {
+
+public:
+	static const bool ENABLED = true;
+
+	TSigCrc16Nibble() : crc(0xFFFF) {}
+
+	void add(uint8_t val) {
+		crc = TCrc::getCrc16Nibble(crc, val);
+	}
+
+	uint32_t get() const {
+		return crc;
+	}
+
+private:
+	uint16_t crc;	///< Текущее значение CRC.
+};
+
+/**	\brief CRC-32 по таблице на полубайт.
+ *
+ */
+class TSigCrc32Nibble {
+
+public:
+	static const bool ENABLED = true;
+
+	TSigCrc32Nibble() : crc(0xFFFFFFFF) {}
+
+	void add(uint8_t val) {
+		crc = TCrc::getCrc32Nibble(crc, val);
+	}
+
+	uint32_t get() const {
+		return ~crc;
+	}
+
+private:
+	uint32_t crc;	///< Текущее значение CRC.
+};
+
+#endif /* TSIGNATURE_H_ */
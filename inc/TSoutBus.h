@@ -6,11 +6,13 @@
 #define TSOUTBUS_H_
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <stdint.h>
 
 /**	\brief Класс работы с шиной сигналов SOut (неисправности/аварии).
  *
- *
+ *	Работа по маске и вывод значения изменяют PORTB и PORTF при запрещенных
+ *	прерываниях, т.к. шина используется и в прерывании таймера (TSoutSeq).
  */
 class TSoutBus
 {
@@ -53,31 +55,47 @@ public:
 // Работа с сигналами по маске, применяется для бит установленных в единицу 
 	void setMask(uint8_t mask) 		
 	{ 
+		uint8_t sreg = SREG;
+		cli();
+
 		PORTB |= (mask & 0x70); 
 		PORTF |= mask & 0x0F; 
 		
 		if (mask & 0x80)
 			setAlarm();
+
+		SREG = sreg;
 	}
 	void clrMask(uint8_t mask)
 	{
+		uint8_t sreg = SREG;
+		cli();
+
 		PORTB &= ~(mask & 0x70);
 		PORTF &= ~(mask & 0x0F);
 		if (mask & 0x80)
 			clrAlarm();
+
+		SREG = sreg;
 	}
 
 	void tglMask(uint8_t mask)
 	{
+		uint8_t sreg = SREG;
+		cli();
+
 		PORTB ^= (mask & 0xF0);
 		PORTF ^= (mask & 0x0F);
 
+		SREG = sreg;
 	}
 	
 // 	Вывод значения на светодиоды
 	void setValue(uint8_t val)
 	{
+		uint8_t sreg = SREG;
 		uint8_t tmp;
+		cli();
 		
 		tmp = PORTB & 0x0F;
 		tmp += (val	^ 0x80) & 0xF0;
@@ -86,6 +104,8 @@ public:
 		tmp = PORTF & 0xF0;
 		tmp += val & 0x0F;
 		PORTF = tmp;
+
+		SREG = sreg;
 	}	
 	
 private:
@@ -0,0 +1,168 @@
+/*
+ * TSoutSeq.h
+ *
+ *	Вывод последовательностей на шину SOut по тикам таймера.
+ */
+
+#ifndef TSOUTSEQ_H_
+#define TSOUTSEQ_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include "TSoutBus.h"
+
+/**	\brief Проигрыватель последовательностей шины SOut.
+ *
+ *	Последовательность - таблица шагов во flash (SStep), каждый шаг
+ *	выводит значение на SOut и держит его заданное кол-во тиков таймера.
+ *	Шаги переключаются в прерывании таймера вызовом tick(), поэтому
+ *	основной цикл не тратит время на отсчет интервалов светодиодов.
+ *
+ *	Последовательность запускается:
+ *	- play() - один раз, до ее окончания isBusy() возвращает true;
+ *	- show() - по кругу, только если не идет последовательность play().
+ *	Такая последовательность прерывается любым следующим запуском.
+ *
+ *	Значение шага может браться из аргумента запуска (OP_ARG), например
+ *	код ошибки или номер теста.
+ */
+class TSoutSeq {
+
+public:
+	/// Операции шага последовательности
+	enum OP {
+		OP_END	= 0,	///< Конец последовательности.
+		OP_SET	= 1,	///< Вывод значения шага.
+		OP_ARG	= 2		///< Вывод аргумента запуска.
+	};
+
+	/// Шаг последовательности (хранится во flash)
+	struct SStep {
+		uint8_t op;			///< Операция (OP).
+		uint8_t value;		///< Значение для OP_SET.
+		uint8_t ticks;		///< Длительность шага, тиков таймера.
+	};
+
+	static const SStep WALK[];		///< Бегущий разряд, 16 с.
+	static const SStep ERROR_CODE[];	///< Код ошибки, 5 с.
+	static const SStep PROGRESS[];	///< Мигание номером теста.
+
+	/**	Конструктор.
+	 *
+	 *	@param bus Шина SOut.
+	 */
+	TSoutSeq(TSoutBus &bus) : bus(bus) {
+		pattern = 0;
+		pos = 0;
+		left = 0;
+		arg = 0;
+		repeat = false;
+		active = false;
+	}
+
+	/**	Однократный вывод последовательности.
+	 *
+	 *	Прерывает текущую последовательность, первый шаг выводится сразу.
+	 *
+	 *	@param p Последовательность.
+	 *	@param a Аргумент для шагов OP_ARG.
+	 */
+	void play(const SStep *p, uint8_t a) {
+		start(p, a, false);
+	}
+
+	/**	Вывод последовательности по кругу.
+	 *
+	 *	Пропускается, если идет последовательность play().
+	 *
+	 *	@param p Последовательность.
+	 *	@param a Аргумент для шагов OP_ARG.
+	 */
+	void show(const SStep *p, uint8_t a) {
+		if (!isBusy()) {
+			start(p, a, true);
+		}
+	}
+
+	/**	Остановка последовательности.
+	 *
+	 *	Значение на шине SOut не меняется.
+	 */
+	void stop() {
+		active = false;
+	}
+
+	/**	Проверка вывода последовательности play().
+	 *
+	 *	@return True - последовательность еще не закончена.
+	 */
+	bool isBusy() const {
+		return active && !repeat;
+	}
+
+	/**	Шаг по тику таймера.
+	 *
+	 *	Вызывается из прерывания таймера.
+	 */
+	void tick() {
+		if (!active)
+			return;
+
+		if (--left == 0) {
+			next();
+		}
+	}
+
+private:
+	TSoutBus &bus;					///< Шина SOut.
+	const SStep *pattern;			///< Текущая последовательность.
+	uint8_t pos;					///< Номер следующего шага.
+	uint8_t left;					///< Осталось тиков текущего шага.
+	uint8_t arg;					///< Аргумент для шагов OP_ARG.
+	bool repeat;					///< Вывод по кругу.
+	volatile bool active;			///< Идет вывод последовательности.
+
+	/**	Запуск последовательности.
+	 *
+	 *	@param p Последовательность.
+	 *	@param a Аргумент для шагов OP_ARG.
+	 *	@param rep Вывод по кругу.
+	 */
+	void start(const SStep *p, uint8_t a, bool rep) {
+		uint8_t sreg = SREG;
+		cli();
+
+		pattern = p;
+		arg = a;
+		repeat = rep;
+		pos = 0;
+		active = true;
+		next();
+
+		SREG = sreg;
+	}
+
+	/**	Переход к следующему шагу последовательности.
+	 *
+	 */
+	void next() {
+		uint8_t op = pgm_read_byte(&pattern[pos].op);
+
+		if (op == OP_END) {
+			if (!repeat) {
+				active = false;
+				return;
+			}
+			pos = 0;
+			op = pgm_read_byte(&pattern[pos].op);
+		}
+
+		bus.setValue((op == OP_ARG) ? arg : pgm_read_byte(&pattern[pos].value));
+		left = pgm_read_byte(&pattern[pos].ticks);
+		pos++;
+	}
+};
+
+#endif /* TSOUTSEQ_H_ */
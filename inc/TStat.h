@@ -0,0 +1,136 @@
+/*
+ * TStat.h
+ *
+ *	Измерение времени и кол-ва обращений к внешней шине в тестах.
+ */
+
+#ifndef TSTAT_H_
+#define TSTAT_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include "TExtBus.h"
+
+/**	\brief Измерения для статистики тестов.
+ *
+ *	Время отсчитывается Timer3 без предделителя, т.е. в тактах МК. Timer3
+ *	настраивается в low_level_init(), старшие 16 разрядов времени считаются
+ *	в прерывании по переполнению (раз в 4.1 мс, около 30 тактов).
+ *
+ *	Обращения к внешней шине аппаратно не считаются, поэтому их учитывают
+ *	сами тесты: одиночные обращения к регистрам - через read(), write(),
+ *	set() и clear(), циклы по памяти - вызовом addBus() по окончании
+ *	каждого цикла или блока с кол-вом, посчитанным по границам цикла.
+ *
+ *	При сборке на ПК время берется из счетчика тактов модели платы.
+ */
+class TStat {
+
+public:
+	/**	Текущее время.
+	 *
+	 *	@return Время, в тактах МК.
+	 */
+	static uint32_t now() {
+#if defined(__AVR__)
+		uint8_t sreg = SREG;
+		cli();
+
+		uint16_t lo = TCNT3;
+		uint16_t hi = high;
+
+		// переполнение, еще не обработанное в прерывании
+		if ((ETIFR & (1 << TOV3)) && (lo < 0x8000)) {
+			hi++;
+		}
+
+		SREG = sreg;
+
+		return (static_cast<uint32_t> (hi) << 16) | lo;
+#else
+		return static_cast<uint32_t> (simBoard.getStat().cycles);
+#endif
+	}
+
+	/**	Обработка переполнения Timer3.
+	 *
+	 *	Вызывается из прерывания TIMER3_OVF_vect.
+	 */
+	static void overflow() {
+		high++;
+	}
+
+	/**	Учет обращений к внешней шине.
+	 *
+	 *	@param n Кол-во обращений.
+	 */
+	static void addBus(uint16_t n) {
+		bus += n;
+	}
+
+	/**	Чтение регистра внешней шины с учетом обращений.
+	 *
+	 *	Каждый байт регистра - отдельное обращение.
+	 *
+	 *	@param reg Регистр.
+	 *	@return Значение.
+	 */
+	template <typename T>
+	static T read(const volatile EXT_REG(T) &reg) {
+		addBus(sizeof(reg));
+		return reg;
+	}
+
+	/**	Запись регистра внешней шины с учетом обращений.
+	 *
+	 *	@param reg Регистр.
+	 *	@param val Значение.
+	 */
+	template <typename T, typename V>
+	static void write(volatile EXT_REG(T) &reg, V val) {
+		reg = static_cast<T> (val);
+		addBus(sizeof(reg));
+	}
+
+	/**	Установка разрядов регистра внешней шины (чтение и запись).
+	 *
+	 *	@param reg Регистр.
+	 *	@param mask Устанавливаемые разряды.
+	 */
+	template <typename T, typename V>
+	static void set(volatile EXT_REG(T) &reg, V mask) {
+		reg |= static_cast<T> (mask);
+		addBus(2 * sizeof(reg));
+	}
+
+	/**	Сброс разрядов регистра внешней шины (чтение и запись).
+	 *
+	 *	@param reg Регистр.
+	 *	@param mask Сбрасываемые разряды.
+	 */
+	template <typename T, typename V>
+	static void clear(volatile EXT_REG(T) &reg, V mask) {
+		reg &= static_cast<T> (~mask);
+		addBus(2 * sizeof(reg));
+	}
+
+	/**	Кол-во обращений к внешней шине.
+	 *
+	 *	@return Обращений с момента запуска.
+	 */
+	static uint32_t getBus() {
+		return bus;
+	}
+
+private:
+	static volatile uint16_t high;		///< Старшие разряды времени.
+#if defined(__AVR__)
+	static uint32_t bus;				///< Обращения к внешней шине.
+#else
+	/// Обращения к внешней шине, свои у модели платы в каждом потоке.
+	static thread_local uint32_t bus;
+#endif
+};
+
+#endif /* TSTAT_H_ */
@@ -10,8 +10,76 @@
 
 #include <avr/io.h>
 #include <avr/pgmspace.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "TSoutBus.h"
+#include "TSoutSeq.h"
+#include "TReport.h"
+#include "TStat.h"
+#include "TExtBus.h"
+#include "TTiming.h"
+#include "TPattern.h"
+#include "TSignature.h"
+#include "TMarch.h"
+#include "TLineTest.h"
+#include "TFailLog.h"
+#include "TRegTest.h"
+#include "TBusBench.h"
+#include "TBusStress.h"
+
+/// Алгоритм проверки памяти FRAM и 2RAM по умолчанию (TTests::MEM_ALG).
+#ifndef MEM_ALG_DEFAULT
+#define MEM_ALG_DEFAULT MEM_ALG_MARCH_C
+#endif
+
+/// Проверка памяти FRAM и 2RAM по умолчанию (TTests::MEM_VERIFY).
+#ifndef MEM_VERIFY_DEFAULT
+#define MEM_VERIFY_DEFAULT MEM_VERIFY_COMPARE
+#endif
+
+/// Сигнатура для MEM_VERIFY_SIGNATURE (см. TSignature.h). При
+/// CRC_NIBBLE_ONLY таблицы на байт не собираются, по умолчанию берется
+/// CRC-16 по таблице на полубайт.
+#ifndef MEM_SIGNATURE
+#if defined(CRC_NIBBLE_ONLY)
+#define MEM_SIGNATURE TSigCrc16Nibble
+#else
+#define MEM_SIGNATURE TSigCrc16
+#endif
+#endif
+
+/// Вывод кода ошибки на SOut по умолчанию (TTests::setErrorDwell()).
+#ifndef ERROR_DWELL_DEFAULT
+#define ERROR_DWELL_DEFAULT true
+#endif
+
+/// Совмещение проверки шины SOut с автоматическими тестами по умолчанию
+/// (TTests::setOverlap()).
+#ifndef OVERLAP_DEFAULT
+#define OVERLAP_DEFAULT false
+#endif
+
+/// Подбор тактов ожидания внешней шины при запуске (TTests::sweepBus()).
+#ifndef BUS_SWEEP
+#define BUS_SWEEP false
+#endif
+
+/// Замер пропускной способности шины после включения питания, перед
+/// тестами FSM (TTests::TEST_BUS_BENCH).
+#ifndef BUS_BENCH
+#define BUS_BENCH false
+#endif
+
+/// Проверка FRAM при нагрузке на шину после включения питания, перед
+/// тестами FSM (TTests::TEST_STRESS), вместо BUS_BENCH.
+#ifndef BUS_STRESS
+#define BUS_STRESS false
+#endif
+
+/// Быстрая самопроверка при запуске вместо тестов FSM (TTests::post()).
+#ifndef POST_PLAN
+#define POST_PLAN false
+#endif
 
 /**	\brief Класс тестов блока БСП.
  *
@@ -19,28 +87,238 @@
  *	В каждом из состоянии тест находится до тех пор, пока не появится
  *	необходимость перейти к следующемй тесту (т.е. бесконечный цикл).
  *
+ *	Каждый тест разбит на шаги, за один вызов main() выполняется не более
+ *	одного шага текущего теста. Шаг 0 выполняется сразу после перехода к
+ *	тесту, остальные с периодом заданным в FSM. Между шагами main() сразу
+ *	возвращает управление, поэтому время ожидания можно отдать спящему
+ *	режиму или другой работе (см. isIdle()).
+ *
  *	Тестирование начинается с шины SOut. Т.к. на нее идет выход сигналов МК
  *	напрямую.
  *
- *	При обнаружении ошибок в тесте, код ошибки на несколько секунд будет
- *	выведен на шину SOut. После этого тест начнется сначала.
+ *	По окончании каждого теста его результат передается кадром по USART1
+ *	(см. TReport). При обнаружении ошибок в тесте выполняется переход FSM
+ *	по ошибке, т.е. тест начнется сначала. Код ошибки при этом на несколько
+ *	секунд выводится на шину SOut в фоне, если этот вывод не запрещен
+ *	(setErrorDwell()).
+ *
+ *	Все изменения шины SOut выполняются последовательностями из flash
+ *	(TSoutSeq), которые переключаются в прерывании таймера. Автоматические
+ *	тесты на время выполнения мигают своим номером, если шина не занята
+ *	выводом кода ошибки или визуальной проверкой. Визуальный тест не
+ *	начинается, пока не закончен вывод кода ошибки.
  *
  *	Флаг цикла \a flag используется для определения временных интервалов.
  *	Например, при мигании светодиодами. Времени отводимом на один цикл и т.д.
+ *	Флаг устанавливается каждый тик таймера (TICK_MS), период шага каждого
+ *	теста задается в тиках в FSM (см. STEP_PERIOD).
+ *
+ *	В режиме совмещения (setOverlap()) визуальная проверка шины SOut идет в
+ *	фоне одновременно с автоматическими тестами. Следующий визуальный тест
+ *	ждет окончания проверки шины SOut, поэтому общее время равно большему
+ *	из времен визуальной проверки и автоматических тестов, а не их сумме.
+ *	Ошибка автоматического теста прерывает проверку шины SOut для вывода
+ *	кода ошибки.
+ *
+ *	Для каждого теста измеряется время выполнения шагов, время ожидания
+ *	между шагами и кол-во обращений к внешней шине (см. TStat). Результаты
+ *	хранятся в блоке статистики SStatBlock, который размещается в .noinit
+ *	и передается по USART1 кадром TReport::TYPE_STAT.
+ *
+ *	Адреса и разряды ошибок тестов памяти и шины данных записываются в
+ *	TFailLog и передаются после результата теста кадром TReport::TYPE_FAIL.
+ *
+ *	В том же блоке хранится контрольная точка FSM (SCheckpoint) с CRC-8:
+ *	текущий тест, кол-во выполненных шагов и код ошибки. Она обновляется
+ *	после каждого шага. После сброса МК не по включению питания (например,
+ *	внешним сторожевым таймером) resume() продолжает тесты с начала
+ *	прерванного теста, а не с TEST_SOUT_BUS. Тест, сбросивший МК
+ *	RESUME_MAX раз подряд, больше не продолжается и считается законченным
+ *	с ошибкой RESUME_ERROR.
+ *
+ *	План тестов (setPlan(), команда TReport::CMD_PLAN по USART1) заменяет
+ *	переходы FSM: итерация - тесты от первого до последнего по переходам
+ *	без ошибки, тест с ошибкой не повторяется. Один тест по кругу - испытание
+ *	на выдержку (например, FRAM при нагреве), последовательность - заданное
+ *	кол-во раз. По окончании итерации передается кадр TReport::TYPE_PLAN со
+ *	счетчиками итераций и ошибок, длительностью и кол-вом обращений к шине.
+ *	План и счетчики хранятся в блоке статистики и продолжаются после сброса
+ *	МК вместе с контрольной точкой.
  *	*/
 class TTests {
 
 public:
+	/// Номера тестов блока БСП
+	enum TESTS {
+		TEST_ERROR 		= 0,	///< Вывод сообщения ошибки теста.
+		TEST_SOUT_BUS	= 1,	///< Проверка шины SOut.
+		TEST_PLIS_REG	= 2,	///< Проверка регистров ПЛИС.
+		TEST_DATA_BUS	= 3,	///< Проверка шин данных BusW/BusR.
+		TEST_FRAM		= 4,	///< Проверка чтения/записи FRAM.
+		TEST_2RAM		= 5,	///< Проверка чтения/записи 2RAM.
+		TEST_EXT_BUS	= 6,	///< Проверка внешней шины данных/адреса.
+		TEST_BUS_BENCH	= 7,	///< Замер пропускной способности шины.
+		TEST_STRESS		= 8,	///< Проверка FRAM при нагрузке на шину.
+		TEST_MAX				///< Максимальное кол-во тестов.
+	};
+
+	/// Значение BusR не установилось (см. getSettle()).
+	static const uint16_t DATA_BUS_FAIL = 0xFFFF;
+
+	/// Продолжений одного теста подряд (resume()), после которых тест
+	/// считается зависшим.
+	static const uint8_t RESUME_MAX = 3;
+
+	/// Код ошибки зависшего теста (resume()).
+	static const uint8_t RESUME_ERROR = 0xFF;
+
+	/// Области внешней шины для подбора тактов ожидания (sweepBus())
+	enum BUS_AREA {
+		BUS_AREA_2RAM	= 0,	///< 2RAM.
+		BUS_AREA_FRAM	= 1,	///< FRAM.
+		BUS_AREA_PLIS	= 2,	///< Регистры ПЛИС.
+		BUS_AREA_MAX			///< Кол-во областей.
+	};
+
+	/// Кол-во проверяемых делителей частоты МК (sweepBus()).
+	static const uint8_t BUS_DIV_MAX = 3;
+
+	/// Кол-во вариантов тактов ожидания SRW11:SRW10.
+	static const uint8_t BUS_WAIT_MAX = 4;
+
+	/// Кол-во проверяемых ячеек области в самопроверке (post()), 2RAM
+	/// проверяется целиком, FRAM - каждая восьмая ячейка, на каждом
+	/// запуске своя восьмая часть.
+	static const uint16_t POST_SAMPLES = 4096;
+
+	/// Шаг адреса проверяемых ячеек в самопроверке (нечетный).
+	static const uint16_t POST_STRIDE = 0x0A5B;
+
+	/// SOut при успешной самопроверке (Cf).
+	static const uint8_t POST_SOUT_PASS = 0x01;
+
+	/// SOut при ошибке самопроверки (Alarm).
+	static const uint8_t POST_SOUT_FAIL = 0x80;
+
+	/// Флаги плана тестов (SPlan::flags)
+	enum PLAN_FLAG {
+		PLAN_STOP_ON_FAIL	= 0x01,	///< Остановка на первом тесте с ошибкой.
+		PLAN_FULL_RATE		= 0x02,	///< Шаги автоматических тестов без
+									///< ожидания тика таймера.
+		PLAN_DONE			= 0x80	///< План закончен (устанавливает МК).
+	};
+
+	/// Алгоритмы проверки памяти FRAM и 2RAM
+	enum MEM_ALG {
+		MEM_ALG_PATTERN		= 0,	///< Псевдослучайная последовательность.
+		MEM_ALG_MATS_PLUS	= 1,	///< MATS+, самый быстрый.
+		MEM_ALG_MARCH_C		= 2,	///< March C-.
+		MEM_ALG_MARCH_B		= 3		///< March B, самый полный.
+	};
+
+	/// Проверка записанной последовательности (MEM_ALG_PATTERN)
+	enum MEM_VERIFY {
+		MEM_VERIFY_COMPARE		= 0,	///< Побайтное сравнение.
+		MEM_VERIFY_SIGNATURE	= 1		///< Сравнение сигнатуры MEM_SIGNATURE.
+	};
+
+	/// Статистика последнего выполнения теста
+	struct SStatTest {
+		uint32_t busy;				///< Тактов МК выполнения шагов.
+		uint32_t wait;				///< Тактов МК ожидания между шагами.
+		uint32_t bus;				///< Обращений к внешней шине в шагах.
+		uint16_t runs;				///< Кол-во выполнений теста.
+	};
+
+	/// Контрольная точка FSM
+	struct SCheckpoint {
+		uint8_t test;				///< Текущий тест.
+		uint8_t step;				///< Выполнено шагов теста.
+		uint8_t error;				///< Код ошибки теста.
+		uint8_t resumes;			///< Продолжений с контрольной точки подряд.
+		uint8_t crc;				///< CRC-8 предыдущих полей.
+	};
+
+	/// План тестов
+	struct SPlan {
+		uint32_t iter;				///< Законченных итераций.
+		uint32_t failed;			///< Итераций с ошибками.
+		uint16_t count;				///< Кол-во итераций, 0 - без ограничения.
+		uint8_t first;				///< Первый тест, TEST_ERROR - плана нет.
+		uint8_t last;				///< Последний тест итерации.
+		uint8_t flags;				///< Флаги (PLAN_FLAG).
+		uint8_t crc;				///< CRC-8 предыдущих полей.
+	};
+
+	/// Блок статистики тестов
+	struct SStatBlock {
+		uint16_t magic;				///< STAT_MAGIC - блок инициализирован.
+		SStatTest test[TEST_MAX];	///< Статистика тестов.
+		SCheckpoint check;			///< Контрольная точка FSM.
+		SPlan plan;					///< План тестов.
+	};
+
+	/// Признак инициализированного блока статистики.
+	static const uint16_t STAT_MAGIC = 0x5354;
+
 	/**	Конструктор.
 	 *
+	 *	Блок статистики \a block сохраняется при сбросе МК, если он размещен
+	 *	в .noinit. При включении питания блок очищается.
+	 *
+	 *	@param block Блок статистики тестов.
 	 */
-	TTests() {
-		plis = (SPlisRegister*) (PLIS_ADR);
-		ram = (S2RamRegister*) (RAM_ADR);
+	TTests(SStatBlock *block) : Seq(SOut),
+			Stress(RAM_ADR + RAM_SIZE - TBusStress::WINDOW,
+					PLIS_ADR + offsetof(SPlisRegister, curAdr)) {
+		stat = block;
+		if (stat->magic != STAT_MAGIC) {
+			for(uint8_t i = 0; i < TEST_MAX; i++) {
+				SStatTest &s = stat->test[i];
+				s.busy = s.wait = s.bus = 0;
+				s.runs = 0;
+			}
+			stat->check.crc = ~getCheckCrc(stat->check);
+			clearPlan();
+			stat->magic = STAT_MAGIC;
+		}
+
+		plis = extPtr<SPlisRegister> (PLIS_ADR);
+		ram = extPtr<S2RamRegister> (RAM_ADR);
 
 		curTest = TEST_SOUT_BUS;
+		period = getPeriod(curTest);
+		cnt = 0;
 		error = 0;
 		flag = false;
+		tick = 0;
+		tickCnt = 0;
+		tickSeen = 0;
+		memAlg = MEM_ALG_DEFAULT;
+		memVerify = MEM_VERIFY_DEFAULT;
+		lineData = 0;
+		lineAdr = 0;
+		failAdr = 0;
+		testTicks = 0;
+		stressQuiet = 0;
+		stressLoaded = 0;
+		errorDwell = ERROR_DWELL_DEFAULT;
+		overlap = OVERLAP_DEFAULT;
+		resumes = 0;
+		testStart = TStat::now();
+		testBusy = 0;
+		testBus = 0;
+		planMask = 0;
+		planTicks = 0;
+		planBus = 0;
+		for(uint8_t bit = 0; bit < 8; bit++) {
+			settle[bit] = 0;
+		}
+		for(uint8_t a = 0; a < BUS_AREA_MAX; a++) {
+			for(uint8_t d = 0; d < BUS_DIV_MAX; d++) {
+				sweep[a][d] = 0;
+			}
+		}
 	}
 
 	/**	Установка флага цикла.
@@ -50,43 +328,323 @@ public:
 	 */
 	void setFlag() {
 		flag = true;
+		tickCnt++;
+		Seq.tick();
 	}
 
 	/**	Тело класса.
 	 *
+	 *	Выполняет очередной шаг текущего теста, если он наступил.
+	 *
+	 *	@return True - если тест закончен и выполнен переход FSM.
+	 */
+	bool main();
+
+	/**	Проверка отсутствия работы до следующего тика таймера.
+	 *
+	 *	Вызывать при запрещенных прерываниях, перед переходом в спящий режим.
+	 *
+	 *	@return True - если до следующего тика main() ничего не сделает.
+	 */
+	bool isIdle() const {
+		return (isPlanDone() || ((cnt != 0) && !isFullRate()) ||
+				isSoutWait()) && (!flag);
+	}
+
+	/**	Переход к тесту.
+	 *
+	 *	Первый шаг нового теста будет выполнен при следующем вызове main().
+	 *
+	 *	@param test Номер теста.
+	 */
+	void setTest(TESTS test);
+
+	/**	Продолжение тестов после сброса МК.
+	 *
+	 *	Вызывается один раз после запуска, до первого вызова main().
+	 *
+	 *	@param cause Причина сброса, значение MCUCSR.
+	 *	@return True - тесты продолжены с контрольной точки (в том числе
+	 *	переходом по ошибке зависшего теста).
+	 */
+	bool resume(uint8_t cause);
+
+	/**	Выбор плана тестов.
+	 *
+	 *	Последний тест должен достигаться из первого по переходам FSM без
+	 *	ошибки. Счетчики плана обнуляются, первый тест начинается заново
+	 *	при следующем вызове main(). Действующий план передается кадром
+	 *	TReport::TYPE_PLAN.
+	 *
+	 *	@param first Первый тест итерации, TEST_ERROR - тесты FSM без плана
+	 *	(с TEST_SOUT_BUS).
+	 *	@param last Последний тест итерации.
+	 *	@param count Кол-во итераций, 0 - без ограничения.
+	 *	@param flags Флаги (PLAN_FLAG).
+	 *	@return False - план неверен, действующий план не изменен.
+	 */
+	bool setPlan(uint8_t first, uint8_t last, uint16_t count, uint8_t flags);
+
+	/**	Действующий план тестов.
+	 *
+	 *	@return План и счетчики законченных итераций.
+	 */
+	const SPlan& getPlan() const {
+		return stat->plan;
+	}
+
+	/**	Проверка окончания плана.
+	 *
+	 *	После окончания main() только принимает команды, на SOut
+	 *	POST_SOUT_PASS или POST_SOUT_FAIL (были итерации с ошибками).
+	 *
+	 *	@return True - план закончен.
+	 */
+	bool isPlanDone() const {
+		return (stat->plan.first != TEST_ERROR) &&
+				(stat->plan.flags & PLAN_DONE);
+	}
+
+	/**	Подбор тактов ожидания внешней шины.
+	 *
+	 *	Для каждого делителя частоты МК (XDIV) и кол-ва тактов ожидания
+	 *	(SRW11:SRW10) выполняется короткая проверка каждой области шины:
+	 *	линии данных и адреса 2RAM и FRAM, регистры ПЛИС. Результат
+	 *	передается кадром TReport::TYPE_SWEEP.
+	 *
+	 *	Вызывается до начала тестов, содержимое 2RAM и FRAM не сохраняется.
+	 *	Прерывания запрещаются только на время каждой проверки (checkArea()),
+	 *	поэтому тики таймера и время TStat после подбора верны.
+	 */
+	void sweepBus();
+
+	/**	Быстрая самопроверка при запуске (POST).
+	 *
+	 *	Проверяются ядрами тестов FSM с уменьшенным объемом, не дольше
+	 *	POST_TIME_MS:
+	 *	- регистры ПЛИС по карте PLIS_REG (TRegTest);
+	 *	- шины BusW -> BusR бегущими единицей и нулем (waitBusR());
+	 *	- линии данных и адреса FRAM и 2RAM (lineCheck());
+	 *	- до POST_SAMPLES ячеек FRAM и 2RAM с шагом POST_STRIDE по
+	 *	сигнатуре MEM_SIGNATURE, если линии исправны.
+	 *
+	 *	FRAM больше POST_SAMPLES, поэтому за один запуск проверяется только
+	 *	часть ее ячеек. Выборка сдвигается по счетчику запусков в FRAM
+	 *	(POST_BOOT_ADR, сохраняется без питания), так что все ячейки FRAM
+	 *	проверяются за FLASH_SIZE / POST_SAMPLES запусков подряд. Тесты
+	 *	памяти FSM (testFram(), testStress()) ячейку счетчика не проверяют
+	 *	(FLASH_FSM_SIZE), а testBusBench() восстанавливает ее, поэтому
+	 *	сдвиг выборки зависит только от кол-ва запусков. Связность ячеек
+	 *	(coupling) выборкой почти не обнаруживается, она остается
+	 *	March-тестам FSM.
+	 *
+	 *	Результат выводится на SOut (POST_SOUT_PASS или POST_SOUT_FAIL) и
+	 *	передается кадром TReport::TYPE_POST. Содержимое 2RAM и FRAM не
+	 *	сохраняется.
+	 *
+	 *	@return Код ошибки. Каждый установленный бит отвечает за отдельную
+	 *	ошибку.
+	 *	@retval 0-бит Регистры ПЛИС.
+	 *	@retval 1-бит Шины BusW/BusR.
+	 *	@retval 2-бит Линии данных/адреса FRAM.
+	 *	@retval 3-бит Линии данных/адреса 2RAM.
+	 *	@retval 4-бит Выборка ячеек FRAM.
+	 *	@retval 5-бит Выборка ячеек 2RAM.
+	 */
+	uint8_t post();
+
+	/**	Проверка CRC программы во flash МК (TFlashCrc).
+	 *
+	 *	Между блоками по EXT_WDT_BLOCK байт сбрасывается внешний
+	 *	сторожевой таймер. Результат передается кадром TReport::TYPE_FLASH,
+	 *	при неверной CRC на SOut выводится POST_SOUT_FAIL. Образ без
+	 *	заполненной записи CRC (не обработан host/crcstamp) ошибкой не
+	 *	считается.
+	 *
+	 *	@return False - CRC программы неверна.
+	 */
+	bool checkFlash();
+
+	/**	Удержание результата самопроверки.
+	 *
+	 *	Вызывается в основном цикле вместо main() при POST_PLAN или неверной
+	 *	CRC программы: по тикам таймера сбрасывается внешний сторожевой
+	 *	таймер, SOut не меняется.
+	 */
+	void holdPost() {
+		if (flag) {
+			flag = false;
+			rstExtWdt();
+		}
+	}
+
+	/**	Результат подбора тактов ожидания.
+	 *
+	 *	@param area Область шины.
+	 *	@param div Номер делителя частоты, 0..BUS_DIV_MAX-1.
+	 *	@return Маска тактов ожидания, при которых проверка прошла.
+	 */
+	uint8_t getSweep(BUS_AREA area, uint8_t div) const {
+		return sweep[area][div];
+	}
+
+	/**	Делитель частоты МК для подбора тактов ожидания.
+	 *
+	 *	@param div Номер делителя частоты, 0..BUS_DIV_MAX-1.
+	 *	@return Делитель, 1 - без деления.
+	 */
+	static uint8_t getSweepDiv(uint8_t div) {
+		uint8_t xdiv = pgm_read_byte(&BUS_XDIV[div]);
+
+		return (xdiv & (1 << XDIVEN)) ? 129 - (xdiv & 0x7F) : 1;
+	}
+
+	/**	Выбор алгоритма проверки памяти FRAM и 2RAM.
+	 *
+	 *	Новый алгоритм будет использован при следующем запуске теста памяти.
+	 *
+	 *	@param alg Алгоритм.
+	 */
+	void setMemAlg(MEM_ALG alg) {
+		memAlg = alg;
+	}
+
+	/**	Выбор проверки записанной в память последовательности.
+	 *
+	 *	Используется только алгоритмом MEM_ALG_PATTERN.
+	 *
+	 *	@param verify Проверка.
+	 */
+	void setMemVerify(MEM_VERIFY verify) {
+		memVerify = verify;
+	}
+
+	/**	Вывод кода ошибки на шину SOut при переходе FSM по ошибке.
+	 *
+	 *	Код ошибки выводится в фоне и не задерживает автоматические тесты,
+	 *	но задерживает следующий визуальный тест. На автоматизированном
+	 *	стенде результат берется из USART1, поэтому вывод можно отключить.
+	 *
+	 *	@param enable True - код ошибки выводится.
+	 */
+	void setErrorDwell(bool enable) {
+		errorDwell = enable;
+	}
+
+	/**	Совмещение проверки шины SOut с автоматическими тестами.
+	 *
+	 *	Используется при следующем запуске теста шины SOut.
+	 *
+	 *	@param enable True - шина SOut проверяется в фоне.
+	 */
+	void setOverlap(bool enable) {
+		overlap = enable;
+	}
+
+	/**	Проверка шины SOut в фоне.
+	 *
+	 *	@return True - проверка еще идет.
+	 */
+	bool isSoutBusy() const {
+		return Seq.isBusy();
+	}
+
+	/**	Неисправные линии данных последнего теста памяти.
+	 *
+	 *	@return Маска линий данных.
+	 */
+	uint8_t getLineData() const {
+		return lineData;
+	}
+
+	/**	Неисправные линии адреса последнего теста памяти.
+	 *
+	 *	@return Маска линий адреса.
+	 */
+	uint16_t getLineAdr() const {
+		return lineAdr;
+	}
+
+	/**	Адрес первой ошибки последнего теста.
+	 *
+	 *	@return Адрес во внешней памяти, 0 - не определен.
+	 */
+	uint16_t getFailAdr() const {
+		return failAdr;
+	}
+
+	/**	Запись ошибок последнего теста.
+	 *
+	 *	@return Запись ошибок.
+	 */
+	const TFailLog& getFailLog() const {
+		return failLog;
+	}
+
+	/**	Блок статистики тестов.
+	 *
+	 *	@return Блок статистики.
+	 */
+	const SStatBlock* getStat() const {
+		return stat;
+	}
+
+	/**	Наибольшее время установления разряда BusR в тесте шин данных.
+	 *
+	 *	@param bit Разряд шины BusW.
+	 *	@return Время, тактов МК.
+	 */
+	uint16_t getSettle(uint8_t bit) const {
+		return settle[bit];
+	}
+
+	/**	Код ошибки последнего теста.
+	 *
+	 *	@return Код ошибки, 0 - ошибок нет.
 	 */
-	void main();
+	uint8_t getError() const {
+		return error;
+	}
+
+	/**	Текущий тест.
+	 *
+	 *	@return Номер теста, который будет выполнен при следующем вызове main().
+	 */
+	TESTS getCurTest() const {
+		return curTest;
+	}
 
 	// Класс работы с шиной SOut
 		TSoutBus SOut;
 
-private:
+	// Последовательности шины SOut
+		TSoutSeq Seq;
 
-	/// Указатель на функцию теста класса TTests
-	typedef uint8_t (TTests::*pTest) (uint8_t time);
+	// Нагрузка на внешнюю шину из прерывания
+		TBusStress Stress;
 
-	/// Массив значений для вычисления CRC-8.
-	static const uint8_t crc8[256];
+	// Канал результатов тестов
+		TReport Report;
 
-	/// Номера тестов блока БСП
-	enum TESTS {
-		TEST_ERROR 		= 0,	///< Вывод сообщения ошибки теста.
-		TEST_SOUT_BUS	= 1,	///< Проверка шины SOut.
-		TEST_PLIS_REG	= 2,	///< Проверка регистров ПЛИС.
-		TEST_DATA_BUS	= 3,	///< Проверка шин данных BusW/BusR.
-		TEST_FRAM		= 4,	///< Проверка чтения/записи FRAM.
-		TEST_2RAM		= 5,	///< Проверка чтения/записи 2RAM.
-		TEST_EXT_BUS	= 6,	///< Проверка внешней шины данных/адреса.
-		TEST_MAX				///< Максимальное кол-во тестов.
-	};
+private:
 
 	/// Возможные переходы в FSM
 	enum FSM_NEXT {
 		FSM_NEXT_NO_ERROR 	= 0,///< Тест закончился без ошибок.
 		FSM_NEXT_ERROR		= 1,///< Тест закончился с ошибой.
-		FSM_NEXT_MAX			///< Максимальное кол-во переходов.
+		FSM_NEXT_MAX,			///< Максимальное кол-во переходов.
+		FSM_NEXT_BUSY		= 0xFF	///< Тест не закончен.
+	};
+
+	/// Периоды шага тестов, в тиках таймера
+	enum STEP_PERIOD {
+		STEP_FAST	= 1,				///< Автоматические тесты.
+		STEP_VISUAL = TICKS_PER_SEC		///< Визуальные тесты.
 	};
 
+	/// Ошибки линий данных/адреса в тестах памяти
+	static const uint8_t MEM_ERROR_LINE = (1 << 3) | (1 << 4);
+
 	/// Используемые значения для регистра init ПЛИС
 	enum REG_INIT {
 		REG_INIT_FRAM_ENABLE  = 0x55,	///< Разрешение работы с FRAM
@@ -95,26 +653,26 @@ private:
 
 	/// структура регистров расположенных в ПЛИС
 	struct SPlisRegister{
-		REG_INIT init;			///<
-		const uint8_t vers;		///< версия прошивки ПЛИС
-		uint16_t dd;			///<
-		uint8_t curAdr;			///<
-		uint8_t extSet;			///<
-		const uint8_t busR;		///< регистр чтения шины BusR
-		uint8_t busW;			///< регистр записи шины BusW
-		uint8_t bankFl;			///<
-		uint8_t null;			///<
+		EXT_REG(REG_INIT) init;			///<
+		const EXT_REG(uint8_t) vers;	///< версия прошивки ПЛИС
+		EXT_REG(uint16_t) dd;			///<
+		EXT_REG(uint8_t) curAdr;		///<
+		EXT_REG(uint8_t) extSet;		///<
+		const EXT_REG(uint8_t) busR;	///< регистр чтения шины BusR
+		EXT_REG(uint8_t) busW;			///< регистр записи шины BusW
+		EXT_REG(uint8_t) bankFl;		///<
+		EXT_REG(uint8_t) null;			///<
 	};
 
 	/// структура параметров расположенных в 2RAM
 	struct S2RamRegister{
-		uint8_t line;			///<
+		EXT_REG(uint8_t) line;			///<
 	};
 
-	/// структура FSM тестов
+	/// структура FSM тестов (хранится во flash)
 	struct SStateFSM{
-		pTest test;					///< текущий тест
-		TESTS next[FSM_NEXT_MAX];	///< таблица переходов состояний
+		uint8_t period;					///< период шага теста, тиков
+		uint8_t next[FSM_NEXT_MAX];		///< таблица переходов состояний
 	};
 
 	// АДРЕСА РЕГИСТРОВ И ПЕРЕМЕННЫХ ВО ВНЕШНЕЙ ПАМЯТИ
@@ -124,6 +682,19 @@ private:
 	static const uint16_t FLASH_ADR  =	0x8000;		///< Начальный адрес FLASH.
 	static const uint16_t FLASH_SIZE =	0x8000;		///< Размер памяти FLASH.
 
+	/// Счетчик запусков самопроверки (post()), последняя ячейка FRAM.
+	static const uint16_t POST_BOOT_ADR = FLASH_ADR + FLASH_SIZE - 1;
+
+	/// Размер FRAM в тестах памяти FSM, без счетчика POST_BOOT_ADR.
+	static const uint16_t FLASH_FSM_SIZE = POST_BOOT_ADR - FLASH_ADR;
+
+	/// Проверка регистров ПЛИС
+	typedef TRegTest<PLIS_ADR> TPlisRegTest;
+
+	static const TPlisRegTest::SReg PLIS_REG[];		///< Карта регистров ПЛИС.
+
+	static const uint8_t BUS_XDIV[BUS_DIV_MAX];		///< Значения XDIV.
+
 	// СТРУКТУРЫ РЕГИСТРОВ И ПЕРЕМЕННЫХ ВО ВНЕШНЕЙ ПАМЯТИ
 	volatile SPlisRegister *plis;					///< Регистры ПЛИС.
 	volatile S2RamRegister *ram;					///< Параметры 2RAM.
@@ -131,28 +702,315 @@ private:
 	static const SStateFSM FSM[TEST_MAX];			///< FSM.
 
 	volatile bool flag;								///< Флаг цикла.
+	uint8_t tick;									///< Тиков с начала шага.
 	TESTS curTest;									///< Текущий тест.
+	uint8_t period;									///< Период шага теста.
+	uint8_t cnt;									///< Номер шага теста.
 	uint8_t error;									///< Ошибки теста.
+	MEM_ALG memAlg;									///< Алгоритм теста памяти.
+	MEM_VERIFY memVerify;							///< Проверка памяти.
+	uint8_t lineData;								///< Неисправные линии данных.
+	uint16_t lineAdr;								///< Неисправные линии адреса.
+	uint16_t failAdr;								///< Адрес первой ошибки.
+	TFailLog failLog;								///< Запись ошибок.
+	volatile uint8_t tickCnt;						///< Счетчик тиков таймера.
+	uint8_t tickSeen;								///< Учтенные тики таймера.
+	uint16_t testTicks;								///< Тиков с начала теста.
+	bool errorDwell;								///< Вывод кода ошибки.
+	bool overlap;									///< Проверка SOut в фоне.
+	uint8_t resumes;								///< Продолжений подряд.
+
+	SStatBlock *stat;								///< Статистика тестов.
+	uint32_t testStart;								///< Время начала теста.
+	uint32_t testBusy;								///< Время шагов теста.
+	uint32_t testBus;								///< Обращений к шине.
+	uint16_t planMask;								///< Тесты с ошибками.
+	uint32_t planTicks;								///< Тиков итерации.
+	uint32_t planBus;								///< Обращений итерации.
+	uint32_t stressQuiet;							///< Проход FRAM без нагрузки.
+	uint32_t stressLoaded;							///< Проход FRAM с нагрузкой.
+	uint16_t settle[8];								///< Установление BusR.
+	uint8_t sweep[BUS_AREA_MAX][BUS_DIV_MAX];		///< Такты ожидания шины.
+
+
+	// ТЕСТЫ (шаг теста)
+	uint8_t testSoutBus(uint8_t step);				// Тест шины SOut.
+	uint8_t testRegPlis(uint8_t step);				// Тест ПЛИС.
+	uint8_t testDataBus(uint8_t step);				// Тест шин BusR, BusW.
+	uint8_t testFram(uint8_t step);					// Тест чтения\записи FRAM.
+	uint8_t test2Ram(uint8_t step);					// Тест чтения\записи 2RAM.
+	uint8_t testExtBus(uint8_t step);				// Тест внешней шины.
+	uint8_t testBusBench(uint8_t step);				// Замер шины.
+	uint8_t testStress(uint8_t step);				// Тест FRAM под нагрузкой.
+	uint8_t testError(uint8_t step);				// Вывод сообщения ошибки.
+
+	// Ожидание установления значения на шине BusR.
+	bool waitBusR(uint8_t val, uint8_t diff, uint32_t start);
+
+	// Короткая проверка области внешней шины.
+	bool checkArea(uint8_t area, uint8_t xdiv, uint8_t wait);
+
+	/**	Кол-во тактов ожидания внешней шины.
+	 *
+	 *	@return Такты ожидания SRW11:SRW10, 0..3.
+	 */
+	static uint8_t getWait() {
+		return (((XMCRA >> SRW11) & 1) << 1) | ((MCUCR >> SRW10) & 1);
+	}
+
+	/**	Установка кол-ва тактов ожидания внешней шины.
+	 *
+	 *	Адрес внешней шины - один сектор (SRL = 0), такты ожидания задаются
+	 *	разрядами SRW11:SRW10 верхнего сектора.
+	 *
+	 *	@param wait Такты ожидания, 0..3.
+	 */
+	static void setWait(uint8_t wait) {
+		XMCRA = (XMCRA & ~(1 << SRW11)) | (((wait >> 1) & 1) << SRW11);
+		MCUCR = (MCUCR & ~(1 << SRW10)) | ((wait & 1) << SRW10);
+	}
+
+	/**	Установка делителя частоты МК.
+	 *
+	 *	Делитель можно менять только при сброшенном XDIVEN.
+	 *
+	 *	@param xdiv Значение XDIV, 0 - без деления.
+	 */
+	static void setXdiv(uint8_t xdiv) {
+		XDIV = 0;
+		if (xdiv != 0) {
+			XDIV = xdiv;
+		}
+	}
+
+	/**	Значение BusR при замкнутых шинах BusW и BusR.
+	 *
+	 *	На проверочной плате BUSW0 -> BUSR3, .., BUSW3 -> BUSR0, старшие
+	 *	разряды остаются как были.
+	 *
+	 *	@param val Значение BusW.
+	 *	@return Значение BusR.
+	 */
+	static uint8_t getBusLoop(uint8_t val) {
+		uint8_t t = (val & 0xF0);
+		t += ((val & 1) << 3);		// BUSW0 -> BUSR3
+		t += ((val & 2) << 1);		// BUSW1 -> BUSR2
+		t += ((val & 4) >> 1);		// BUSW2 -> BUSR1
+		t += ((val & 8) >> 3);		// BUSW3 -> BUSR0
+		return t;
+	}
+
+	/**	Ожидание окончания последовательности на шине SOut.
+	 *
+	 *	Визуальный тест не начинается, пока шина SOut занята проверкой в
+	 *	фоне или выводом кода ошибки.
+	 *
+	 *	@return True - текущий тест ждет.
+	 */
+	bool isSoutWait() const {
+		return Seq.isBusy() && (cnt == 0) && (period == STEP_VISUAL);
+	}
+
+	// Выполнение шага теста.
+	uint8_t runTest(TESTS test, uint8_t step);
+
+	// Сохранение статистики законченного теста.
+	void saveStat();
+
+	// Сохранение контрольной точки FSM.
+	void saveCheckpoint();
+
+	// Следующий тест плана, учет законченного теста в итерации.
+	TESTS getPlanNext(bool err);
+
+	// Выполнение принятой команды.
+	void runCmd();
+
+	// Кадр действующего плана.
+	void sendPlan();
+
+	/**	Сброс плана, тесты FSM без плана.
+	 *
+	 */
+	void clearPlan() {
+		SPlan &p = stat->plan;
+
+		p.iter = 0;
+		p.failed = 0;
+		p.count = 0;
+		p.first = TEST_ERROR;
+		p.last = TEST_ERROR;
+		p.flags = 0;
+		p.crc = getPlanCrc(p);
+	}
+
+	/**	Шаги теста без ожидания тика таймера (PLAN_FULL_RATE).
+	 *
+	 *	@return True - текущий автоматический тест идет без ожидания.
+	 */
+	bool isFullRate() const {
+		return (stat->plan.first != TEST_ERROR) &&
+				(stat->plan.flags & PLAN_FULL_RATE) && (period == STEP_FAST);
+	}
 
+	/**	CRC-8 блока байт.
+	 *
+	 *	@param p Блок.
+	 *	@param size Кол-во байт.
+	 *	@return CRC.
+	 */
+	static uint8_t getBlockCrc(const void *p, uint8_t size) {
+		const uint8_t *b = static_cast<const uint8_t*> (p);
+		uint8_t crc = 0;
+
+		for(uint8_t i = 0; i < size; i++) {
+			crc = TCrc::getCrc8(crc, b[i]);
+		}
+
+		return crc;
+	}
+
+	/**	CRC-8 плана тестов.
+	 *
+	 *	@param p План.
+	 *	@return CRC полей до \a crc (после него - выравнивание на хосте).
+	 */
+	static uint8_t getPlanCrc(const SPlan &p) {
+		return getBlockCrc(&p, offsetof(SPlan, crc));
+	}
 
-	// ТЕСТЫ
-	uint8_t testSoutBus(uint8_t value);				// Тест шины SOut.
-	uint8_t testRegPlis(uint8_t value);				// Тест ПЛИС.
-	uint8_t testDataBus(uint8_t value);				// Тест шин BusR, BusW.
-	uint8_t testFram(uint8_t value);				// Тест чтения\записи FRAM.
-	uint8_t test2Ram(uint8_t value);				// Тест чтения\записи 2RAM.
-	uint8_t testExtBus(uint8_t value);				// Тест внешней шины.
-	uint8_t testError(uint8_t value);				// Вывод сообщения ошибки.
+	/**	CRC-8 контрольной точки.
+	 *
+	 *	@param c Контрольная точка.
+	 *	@return CRC всех полей, кроме \a crc.
+	 */
+	static uint8_t getCheckCrc(const SCheckpoint &c) {
+		return getBlockCrc(&c, sizeof(c) - 1);
+	}
 
+	/**	Период шага теста.
+	 *
+	 *	@param test Номер теста.
+	 *	@return Период шага, в тиках таймера.
+	 */
+	static uint8_t getPeriod(TESTS test) {
+		return pgm_read_byte(&FSM[test].period);
+	}
 
-	// Вывод кода ошибки на шину SOut.
-	uint8_t printError(uint8_t value);
+	/**	Следующий тест по таблице переходов FSM.
+	 *
+	 *	@param test Номер теста.
+	 *	@param next Результат теста (FSM_NEXT).
+	 *	@return Номер следующего теста.
+	 */
+	static TESTS getNext(TESTS test, uint8_t next) {
+		return static_cast<TESTS> (pgm_read_byte(&FSM[test].next[next]));
+	}
+
+	// Проверка области внешней памяти заданной последовательностью.
+	template <class TPattern, class TSig>
+	uint8_t memTest(volatile EXT_REG(uint8_t) *ptr, uint16_t size,
+			uint8_t seed);
+
+	// Проверка области внешней памяти последовательностью шага теста.
+	template <class TSig>
+	uint8_t memPattern(volatile EXT_REG(uint8_t) *ptr, uint16_t size,
+			uint8_t step);
+
+	// Проверка области внешней памяти на шаге теста.
+	template <uint16_t ADR, uint16_t SIZE>
+	uint8_t memStep(uint8_t step);
+
+	// Проверка линий данных и адреса области внешней памяти.
+	template <uint16_t ADR, uint16_t SIZE>
+	uint8_t lineCheck();
+
+	// Проверка выборки ячеек области внешней памяти по сигнатуре.
+	template <uint16_t ADR, uint16_t SIZE>
+	uint8_t memSample(uint8_t part);
+
+	/**	Кол-во шагов теста памяти FRAM и 2RAM.
+	 *
+	 *	@return Кол-во шагов для текущего алгоритма.
+	 */
+	uint8_t getMemSteps() const {
+		return (memAlg == MEM_ALG_PATTERN) ? 5 : 4;
+	}
+
+	/**	Учет тиков таймера, прошедших с предыдущего вызова.
+	 *
+	 *	Счетчик тиков в прерывании 8-битный, поэтому читается без запрета
+	 *	прерываний. Вызывать надо чаще, чем раз в 255 тиков.
+	 */
+	void countTicks() {
+		uint8_t ticks = tickCnt;
+
+		testTicks += static_cast<uint8_t> (ticks - tickSeen);
+		tickSeen = ticks;
+	}
+
+	/**	Запись ошибки пары байт теста памяти.
+	 *
+	 *	@param p Указатель на первый байт пары.
+	 *	@param bits0 Ошибочные разряды первого байта.
+	 *	@param bits1 Ошибочные разряды второго байта.
+	 */
+	void logPair(volatile EXT_REG(uint8_t) *p, uint8_t bits0, uint8_t bits1) {
+		uint16_t adr = extAdr(p);
+
+		setFailAdr(adr);
+		if (bits0 != 0) {
+			failLog.add(adr, bits0);
+		}
+		if (bits1 != 0) {
+			failLog.add(adr + 1, bits1);
+		}
+	}
+
+	/**	Сохранение адреса ошибки, если он еще не определен в текущем тесте.
+	 *
+	 *	@param adr Адрес ошибки.
+	 */
+	void setFailAdr(uint16_t adr) {
+		if (failAdr == 0) {
+			failAdr = adr;
+		}
+	}
+
+	/**	Проверка наступления очередного шага теста.
+	 *
+	 *	@param period Период шага, в тиках таймера.
+	 *	@return True - если с начала предыдущего шага прошло \a period тиков.
+	 */
+	bool isStep(uint8_t period) {
+		if (!flag)
+			return false;
+
+		flag = false;
+		if (++tick < period)
+			return false;
+
+		tick = 0;
+		return true;
+	}
+
+	/**	Конец блока памяти, проверяемого между сбросами сторожевого таймера.
+	 *
+	 *	@param i Начало блока, смещение от начала области.
+	 *	@param size Размер области.
+	 *	@return Смещение конца блока.
+	 */
+	static uint16_t getBlockEnd(uint16_t i, uint16_t size) {
+		const uint16_t block = EXT_WDT_BLOCK;
+
+		return (size - i > block) ? i + block : size;
+	}
 
-	/**	Сброс внешнего сторожевого таймера, записью в 2RAM.
+	/**	Сброс внешнего сторожевого таймера, обращением к 2RAM.
 	 *
 	 */
 	void rstExtWdt() {
-		volatile uint8_t tmp = ram->line;
+		TStat::read(ram->line);
 	}
 };
 
@@ -0,0 +1,105 @@
+/*
+ * TTiming.h
+ *
+ *	Временные параметры тестов, вычисляемые на этапе компиляции из F_CPU.
+ *
+ *	Timer1 работает в режиме CTC и формирует системный тик с периодом
+ *	TICK_MS. Каждый тест задает свой период шага в тиках: автоматические
+ *	тесты выполняются на каждом тике, визуальные - с периодом, достаточным
+ *	для наблюдения оператором.
+ */
+
+#ifndef TTIMING_H_
+#define TTIMING_H_
+
+#ifndef F_CPU
+#error "F_CPU not defined"
+#endif
+
+/// Период системного тика, мс.
+#define TICK_MS				10
+
+/// Кол-во тиков в секунде.
+#define TICKS_PER_SEC		(1000 / TICK_MS)
+
+/// Предделитель Timer1.
+#define TIMER1_PRESCALER	64
+
+/// Биты выбора предделителя Timer1 (CS12..CS10), должны совпадать с
+/// TIMER1_PRESCALER.
+#define TIMER1_CS			((0 << CS12) | (1 << CS11) | (1 << CS10))
+
+/// Значение регистра OCR1A для периода TICK_MS.
+#define TIMER1_OCR	((F_CPU / TIMER1_PRESCALER) * TICK_MS / 1000 - 1)
+
+#if (TIMER1_OCR > 0xFFFF) || (TIMER1_OCR < 1)
+#error "TICK_MS is out of range for TIMER1_PRESCALER"
+#endif
+
+/// Перевод времени в мс в кол-во тиков.
+#define MS_TO_TICKS(ms)		((ms) / TICK_MS)
+
+/// Перевод времени в мкс в кол-во тактов МК.
+#define US_TO_CYCLES(us)	((F_CPU / 1000000UL) * (us))
+
+/// Максимальное время установления BusR после записи BusW, мкс. Прежде
+/// тест просто ждал 10 + 40 мкс на каждое значение.
+#define DATA_BUS_TIMEOUT_US	50
+
+/// Период прерывания Timer2 нагрузки на шину (TBusStress), мкс.
+#define STRESS_PERIOD_US	20
+
+/// Предделитель Timer2 нагрузки на шину.
+#define TIMER2_PRESCALER	8
+
+/// Биты выбора предделителя Timer2 (TIMER2_PRESCALER = 8).
+#define TIMER2_CS			((0 << CS22) | (1 << CS21) | (0 << CS20))
+
+/// Значение регистра OCR2 для периода STRESS_PERIOD_US.
+#define TIMER2_OCR	(US_TO_CYCLES(STRESS_PERIOD_US) / TIMER2_PRESCALER - 1)
+
+#if (TIMER2_OCR > 0xFF) || (TIMER2_OCR < 1)
+#error "STRESS_PERIOD_US is out of range for TIMER2_PRESCALER"
+#endif
+
+/// Наибольшее время быстрой самопроверки при запуске (TTests::post()), мс.
+#define POST_TIME_MS		100
+
+/// Минимальный таймаут внешнего сторожевого таймера, мс.
+#define EXT_WDT_TIMEOUT_MS	100
+
+/// Оценка сверху длительности проверки одного байта памяти, тактов МК
+/// (запись и два чтения по внешней шине, генерация и сравнение).
+#define MEM_CYCLES_PER_BYTE	32
+
+/// Оценка сверху длительности CRC-32 одного байта flash (TFlashCrc), тактов
+/// МК (чтение байта образа и четырех байт таблицы, сдвиги и xor).
+#define FLASH_CRC_CYCLES_PER_BYTE	32
+
+/// Кол-во байт памяти, проверяемых между сбросами внешнего сторожевого
+/// таймера. Берется с четырехкратным запасом по таймауту, число четное.
+#define EXT_WDT_BLOCK	(((F_CPU / 1000) * EXT_WDT_TIMEOUT_MS / 4 / \
+		MEM_CYCLES_PER_BYTE) & ~1UL)
+
+#if (EXT_WDT_BLOCK < 2) || (EXT_WDT_BLOCK > 0x8000)
+#error "EXT_WDT_BLOCK is out of range"
+#endif
+
+/// Скорость USART1 канала результатов (TReport), бод.
+#define UART_BAUD			1000000UL
+
+/// Значение регистра UBRR1 для UART_BAUD в режиме удвоения скорости (U2X1).
+#define UART_UBRR	((F_CPU / 8 + UART_BAUD / 2) / UART_BAUD - 1)
+
+/// Реальная скорость USART1, бод.
+#define UART_BAUD_REAL	(F_CPU / 8 / (UART_UBRR + 1))
+
+#if (UART_UBRR > 0x0FFF) || (UART_BAUD_REAL * 50 > UART_BAUD * 51) || \
+		(UART_BAUD_REAL * 50 < UART_BAUD * 49)
+#error "UART_BAUD error is more than 2% for F_CPU"
+#endif
+
+/// Время передачи байта по USART1 (старт, 8 бит, стоп), мкс с запасом.
+#define UART_BYTE_US	(10 * 1000000UL / UART_BAUD_REAL + 1)
+
+#endif /* TTIMING_H_ */
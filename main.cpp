@@ -1,10 +1,13 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include <util/delay.h>
 #include <stdint.h>
 
 #include "inc\TSoutBus.h"
 #include "inc\TTests.h"
+#include "inc\TTiming.h"
+#include "inc\TStat.h"
 
 #define INITSECTION __attribute__((section(".init3")))
 #define NOINIT	    __attribute__((section (".noinit")))
@@ -13,18 +16,61 @@
 // инициализация периферии
 INITSECTION NORETURN void low_level_init();
 
+// статистика и контрольная точка тестов, сохраняются при сбросе МК
+TTests::SStatBlock testStat NOINIT;
+
 // тесты
-TTests tests;
+TTests tests(&testStat);
 
 /**	Main
  *
  */
 __attribute__ ((OS_main)) int main() {
+	// причина сброса, флаги очищаются для следующего сброса
+	uint8_t cause = MCUCSR;
+	MCUCSR = 0;
 
+	set_sleep_mode(SLEEP_MODE_IDLE);
 	sei();
+
+	tests.Report.sendStart();
+	bool hold = true;
+	if (!tests.checkFlash()) {
+		// CRC программы неверна: ошибка остается на SOut, тесты не выполняются
+	} else if (POST_PLAN) {
+		// результат самопроверки остается на SOut, тесты FSM не выполняются
+		tests.post();
+	} else {
+		if (BUS_SWEEP) {
+			tests.sweepBus();
+		}
+		if (tests.resume(cause)) {
+			// продолжение прерванного теста
+		} else if (BUS_STRESS) {
+			// один раз после запуска, затем тесты FSM с начала
+			tests.setTest(TTests::TEST_STRESS);
+		} else if (BUS_BENCH) {
+			tests.setTest(TTests::TEST_BUS_BENCH);
+		}
+		hold = false;
+	}
 	
 	while(1) {
-		tests.main();
+		if (hold) {
+			tests.holdPost();
+		} else {
+			tests.main();
+		}
+
+		// до следующего тика таймера работы нет, МК засыпает
+		cli();
+		if (hold || tests.isIdle()) {
+			sleep_enable();
+			sei();
+			sleep_cpu();
+			sleep_disable();
+		}
+		sei();
 	}
 }
 
@@ -32,6 +78,18 @@ ISR(TIMER1_COMPA_vect) {
 	tests.setFlag();
 }
 
+ISR(TIMER2_COMP_vect) {
+	tests.Stress.isr();
+}
+
+ISR(USART1_RX_vect) {
+	tests.Report.rxIsr();
+}
+
+ISR(TIMER3_OVF_vect) {
+	TStat::overflow();
+}
+
 
 void low_level_init() {
    // без предделителя, clk I/O = 16000
@@ -67,19 +125,31 @@ void low_level_init() {
 
 		//********** Внешняя память **********
 
-    XMCRA = 0x06;         // Один сектор без тактов ожидания
+    XMCRA = 0x06;         // Один сектор, 2 такта ожидания (SRW11)
     XMCRB = (1 << XMBK);         // 64К c запоминанием состояния шины
     MCUCR = (1 << SRE);        // Разрешение внешней памяти
 
+	// USART1 канал результатов тестов: UART_BAUD, 8N1, прием команд по
+	// прерыванию
+	UBRR1H = (UART_UBRR >> 8);
+	UBRR1L = (UART_UBRR & 0xFF);
+	UCSR1A = (1 << U2X1);
+	UCSR1C = (1 << UCSZ11) | (1 << UCSZ10);
+	UCSR1B = (1 << TXEN1) | (1 << RXEN1) | (1 << RXCIE1);
+
 	// CTC по OCR1A
-	// предделитель 1024
-	// счет 15625 цилков
-	// получаем 1 секунду
+	// предделитель TIMER1_PRESCALER
+	// получаем системный тик TICK_MS
 	TCCR1A = (0 << WGM11) | (0 << WGM10);
 	TCCR1B = (0 << WGM13) | (1 << WGM12);
-	OCR1A = 15625 - 1;
+	OCR1A = TIMER1_OCR;
 	TIMSK |= (1 << OCIE1A);
-	TCCR1B |=  (1 << CS12) | (0 << CS11) | (1 << CS10);
+	TCCR1B |= TIMER1_CS;
+
+	// Timer3 без предделителя, время для статистики тестов (TStat)
+	TCCR3A = 0;
+	TCCR3B = (1 << CS30);
+	ETIMSK |= (1 << TOIE3);
 }
 
 
@@ -0,0 +1,10 @@
+/*
+ * TBusBench.cpp
+ *
+ *	Замер пропускной способности внешней шины.
+ */
+#include <stdint.h>
+
+#include "../inc/TBusBench.h"
+
+volatile uint8_t TBusBench::sink = 0;
@@ -0,0 +1,88 @@
+/*
+ * TFlashCrc.cpp
+ *
+ *	Проверка целостности программы во flash МК.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../inc/TFlashCrc.h"
+
+/**	Запись длины и CRC образа.
+ *
+ *	Заполняется после сборки программой host/crcstamp.
+ */
+const TFlashCrc::SStamp TFlashCrc::STAMP PROGMEM = {
+		MAGIC, 0xFFFFFFFFUL, 0xFFFFFFFFUL
+};
+
+// Начало проверки
+bool TFlashCrc::begin() {
+	uint16_t stamp = getStampAdr();
+	const SStamp *s = static_cast<const SStamp*> (getPtr(stamp));
+
+	adr = 0;
+	field = stamp + offsetof(SStamp, crc);
+	len = pgm_read_dword(&s->len);
+	crc = 0;
+	sig = TSig();
+
+	if ((pgm_read_dword(&s->magic) != MAGIC) || (len == 0xFFFFFFFFUL)) {
+		result = RESULT_UNSTAMPED;
+		return false;
+	}
+
+	// запись должна быть внутри образа, образ - в первых 64 КБ
+	if ((len > 0x10000UL) || (len < field + sizeof(s->crc))) {
+		result = RESULT_BAD;
+		return false;
+	}
+
+	return true;
+}
+
+// Расчет CRC следующего блока flash
+bool TFlashCrc::next(uint16_t block) {
+	// поле crc записи в CRC не входит
+	if (adr == field) {
+		adr += sizeof(uint32_t);
+	}
+
+	uint32_t end = (adr < field) ? field : len;
+	uint16_t n = (end - adr > block) ? block : end - adr;
+
+	add(adr, n);
+	adr += n;
+	if (adr < len)
+		return false;
+
+	const SStamp *s = static_cast<const SStamp*> (getPtr(getStampAdr()));
+
+	crc = sig.get();
+	result = (crc == pgm_read_dword(&s->crc)) ? RESULT_OK : RESULT_BAD;
+	return true;
+}
+
+/**	Добавление к CRC области flash.
+ *
+ *	Flash читается по 4 байта, остаток - по байту.
+ *
+ *	@param from Начальный адрес.
+ *	@param n Кол-во байт.
+ */
+void TFlashCrc::add(uint16_t from, uint16_t n) {
+	const uint8_t *p = static_cast<const uint8_t*> (getPtr(from));
+
+	for(; n >= 4; n -= 4, p += 4) {
+		uint32_t val = pgm_read_dword(p);
+
+		sig.add(val);
+		sig.add(val >> 8);
+		sig.add(val >> 16);
+		sig.add(val >> 24);
+	}
+
+	for(; n != 0; n--, p++) {
+		sig.add(pgm_read_byte(p));
+	}
+}
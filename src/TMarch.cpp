@@ -0,0 +1,47 @@
+/*
+ * TMarch.cpp
+ *
+ *	Таблицы элементов March-тестов.
+ */
+#include <avr/pgmspace.h>
+#include <stdint.h>
+
+#include "../inc/TMarch.h"
+
+#define R0	SMarchElement::OP_R0
+#define R1	SMarchElement::OP_R1
+#define W0	SMarchElement::OP_W0
+#define W1	SMarchElement::OP_W1
+#define UP	SMarchElement::DIR_UP
+#define DOWN SMarchElement::DIR_DOWN
+#define END SMarchElement::DIR_END
+
+/// MATS+: {(w0); up(r0,w1); down(r1,w0)}
+const SMarchElement marchMatsPlus[] PROGMEM = {
+		{ UP,	1, {W0} },					//
+		{ UP,	2, {R0, W1} },				//
+		{ DOWN,	2, {R1, W0} },				//
+		{ END,	0, {} }						//
+};
+
+/// March C-: {(w0); up(r0,w1); up(r1,w0); down(r0,w1); down(r1,w0); (r0)}
+const SMarchElement marchCMinus[] PROGMEM = {
+		{ UP,	1, {W0} },					//
+		{ UP,	2, {R0, W1} },				//
+		{ UP,	2, {R1, W0} },				//
+		{ DOWN,	2, {R0, W1} },				//
+		{ DOWN,	2, {R1, W0} },				//
+		{ UP,	1, {R0} },					//
+		{ END,	0, {} }						//
+};
+
+/// March B: {(w0); up(r0,w1,r1,w0,r0,w1); up(r1,w0,w1);
+///	down(r1,w0,w1,w0); down(r0,w1,w0)}
+const SMarchElement marchB[] PROGMEM = {
+		{ UP,	1, {W0} },					//
+		{ UP,	6, {R0, W1, R1, W0, R0, W1} },	//
+		{ UP,	3, {R1, W0, W1} },			//
+		{ DOWN,	4, {R1, W0, W1, W0} },		//
+		{ DOWN,	3, {R0, W1, W0} },			//
+		{ END,	0, {} }						//
+};
@@ -0,0 +1,228 @@
+/*
+ * TReport.cpp
+ *
+ *	Передача результатов тестов по USART1 в двоичном виде.
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+
+#include "../inc/TReport.h"
+#include "../inc/TTiming.h"
+
+// Кадр запуска тестов
+void TReport::sendStart() {
+	begin(TYPE_START, 3);
+	put(VERSION);
+	put(TICK_MS);
+	put(F_CPU / 1000000UL);
+	end();
+}
+
+// Кадр результата теста
+void TReport::sendResult(uint8_t test, uint8_t error, uint16_t adr,
+		uint16_t ticks) {
+	begin(TYPE_RESULT, 6);
+	put(test);
+	put(error);
+	put16(adr);
+	put16(ticks);
+	end();
+}
+
+// Кадр статистики теста
+void TReport::sendStat(uint8_t test, uint32_t busy, uint32_t wait,
+		uint32_t bus) {
+	begin(TYPE_STAT, 13);
+	put(test);
+	put32(busy);
+	put32(wait);
+	put32(bus);
+	end();
+}
+
+// Кадр проверки CRC программы во flash
+void TReport::sendFlash(uint8_t result, uint32_t len, uint32_t crc,
+		uint32_t cycles) {
+	begin(TYPE_FLASH, 13);
+	put(result);
+	put32(len);
+	put32(crc);
+	put32(cycles);
+	end();
+}
+
+// Кадр времени установления шины BusR
+void TReport::sendSettle(uint16_t timeout, const uint16_t settle[8]) {
+	begin(TYPE_SETTLE, 18);
+	put16(timeout);
+	for(uint8_t bit = 0; bit < 8; bit++) {
+		put16(settle[bit]);
+	}
+	end();
+}
+
+// Кадр причины сброса МК
+void TReport::sendReset(uint8_t cause, bool resumed, uint8_t test,
+		uint8_t step, uint8_t error, uint8_t resumes) {
+	begin(TYPE_RESET, 6);
+	put(cause);
+	put(resumed ? 1 : 0);
+	put(test);
+	put(step);
+	put(error);
+	put(resumes);
+	end();
+}
+
+// Кадр адресов и разрядов ошибок теста
+void TReport::sendFail(uint8_t test, const TFailLog &log) {
+	begin(TYPE_FAIL, 6 + 5 * log.getNum());
+	put(test);
+	put16(log.getFails());
+	put16(log.getLost());
+	put(log.getMask());
+	for(uint8_t i = 0; i < log.getNum(); i++) {
+		const TFailLog::SRun &r = log.getRun(i);
+		put16(r.adr);
+		put16(r.len);
+		put(r.mask);
+	}
+	end();
+}
+
+// Кадр подбора тактов ожидания внешней шины
+void TReport::sendSweep(uint8_t wait, const uint8_t *div, uint8_t divs,
+		const uint8_t *pass, uint8_t areas) {
+	begin(TYPE_SWEEP, 3 + divs + areas * divs);
+	put(wait);
+	put(divs);
+	for(uint8_t i = 0; i < divs; i++) {
+		put(div[i]);
+	}
+	put(areas);
+	for(uint8_t i = 0; i < areas * divs; i++) {
+		put(pass[i]);
+	}
+	end();
+}
+
+// Кадр пропускной способности внешней шины
+void TReport::sendBench(uint8_t area, uint16_t bytes, const uint32_t *cycles,
+		uint8_t kinds) {
+	begin(TYPE_BENCH, 4 + 4 * kinds);
+	put(area);
+	put16(bytes);
+	put(kinds);
+	for(uint8_t i = 0; i < kinds; i++) {
+		put32(cycles[i]);
+	}
+	end();
+}
+
+// Кадр проверки FRAM при нагрузке на шину
+void TReport::sendStress(uint32_t quiet, uint32_t loaded, uint32_t calls,
+		uint16_t ramErrors, uint16_t regErrors) {
+	begin(TYPE_STRESS, 16);
+	put32(quiet);
+	put32(loaded);
+	put32(calls);
+	put16(ramErrors);
+	put16(regErrors);
+	end();
+}
+
+// Кадр быстрой самопроверки при запуске
+void TReport::sendPost(uint8_t error, uint32_t cycles, uint32_t bus) {
+	begin(TYPE_POST, 9);
+	put(error);
+	put32(cycles);
+	put32(bus);
+	end();
+}
+
+// Кадр плана тестов
+void TReport::sendPlan(uint8_t first, uint8_t last, uint8_t flags,
+		uint16_t count, uint32_t iter, uint32_t failed, uint16_t mask,
+		uint32_t ticks, uint32_t bus) {
+	begin(TYPE_PLAN, 23);
+	put(first);
+	put(last);
+	put(flags);
+	put16(count);
+	put32(iter);
+	put32(failed);
+	put16(mask);
+	put32(ticks);
+	put32(bus);
+	end();
+}
+
+// Прием кадра команды
+bool TReport::receive() {
+	// байты, не забранные прерыванием (на модели платы прерывания нет)
+	uint8_t sreg = SREG;
+	cli();
+	while (UCSR1A & (1 << RXC1)) {
+		rxIsr();
+	}
+	SREG = sreg;
+
+	while (rxTail != rxHead) {
+		uint8_t val = rxBuf[rxTail];
+
+		rxTail = (rxTail + 1) & (RX_BUF_SIZE - 1);
+
+		if (rxPos == 0) {
+			if (val == SYNC) {
+				rxCrc = 0;
+				rxPos = 1;
+			}
+			continue;
+		}
+
+		// CRC после данных
+		if (rxPos == 4 + rxLen) {
+			rxPos = 0;
+			if (val == rxCrc)
+				return true;
+			continue;
+		}
+
+		rxCrc = TCrc::getCrc8(rxCrc, val);
+		if (rxPos == 1) {
+			rxLen = val;
+			if (rxLen > CMD_DATA_MAX) {
+				rxPos = 0;
+				continue;
+			}
+		} else if (rxPos == 3) {
+			rxType = val;
+		} else if (rxPos > 3) {
+			rxData[rxPos - 4] = val;
+		}
+		rxPos++;
+	}
+
+	return false;
+}
+
+/**	Начало кадра.
+ *
+ *	@param type Тип кадра.
+ *	@param len Кол-во байт данных.
+ */
+void TReport::begin(TYPE type, uint8_t len) {
+	send(SYNC);
+	crc = 0;
+	put(len);
+	put(seq++);
+	put(type);
+}
+
+/**	Конец кадра, передача CRC.
+ *
+ */
+void TReport::end() {
+	send(crc);
+}
@@ -0,0 +1,45 @@
+/*
+ * TSoutSeq.cpp
+ *
+ *	Последовательности шины SOut.
+ */
+#include <avr/pgmspace.h>
+#include <stdint.h>
+
+#include "../inc/TSoutSeq.h"
+#include "../inc/TTiming.h"
+
+/// Бегущий разряд от старшего к младшему, дважды, по 1 с на разряд.
+const TSoutSeq::SStep TSoutSeq::WALK[] PROGMEM = {
+		{ OP_SET, 0x80, TICKS_PER_SEC },
+		{ OP_SET, 0x40, TICKS_PER_SEC },
+		{ OP_SET, 0x20, TICKS_PER_SEC },
+		{ OP_SET, 0x10, TICKS_PER_SEC },
+		{ OP_SET, 0x08, TICKS_PER_SEC },
+		{ OP_SET, 0x04, TICKS_PER_SEC },
+		{ OP_SET, 0x02, TICKS_PER_SEC },
+		{ OP_SET, 0x01, TICKS_PER_SEC },
+		{ OP_SET, 0x80, TICKS_PER_SEC },
+		{ OP_SET, 0x40, TICKS_PER_SEC },
+		{ OP_SET, 0x20, TICKS_PER_SEC },
+		{ OP_SET, 0x10, TICKS_PER_SEC },
+		{ OP_SET, 0x08, TICKS_PER_SEC },
+		{ OP_SET, 0x04, TICKS_PER_SEC },
+		{ OP_SET, 0x02, TICKS_PER_SEC },
+		{ OP_SET, 0x01, TICKS_PER_SEC },
+		{ OP_END, 0, 0 }
+};
+
+/// Код ошибки, 5 с.
+const TSoutSeq::SStep TSoutSeq::ERROR_CODE[] PROGMEM = {
+		{ OP_ARG, 0, TICKS_PER_SEC * 5 / 2 },
+		{ OP_ARG, 0, TICKS_PER_SEC * 5 / 2 },
+		{ OP_END, 0, 0 }
+};
+
+/// Номер теста мигает с частотой 1 Гц.
+const TSoutSeq::SStep TSoutSeq::PROGRESS[] PROGMEM = {
+		{ OP_ARG, 0, TICKS_PER_SEC / 2 },
+		{ OP_SET, 0, TICKS_PER_SEC / 2 },
+		{ OP_END, 0, 0 }
+};
@@ -0,0 +1,16 @@
+/*
+ * TStat.cpp
+ *
+ *	Измерение времени и кол-ва обращений к внешней шине в тестах.
+ */
+#include <stdint.h>
+
+#include "../inc/TStat.h"
+
+volatile uint16_t TStat::high = 0;
+
+#if defined(__AVR__)
+uint32_t TStat::bus = 0;
+#else
+thread_local uint32_t TStat::bus = 0;
+#endif
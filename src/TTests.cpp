@@ -5,392 +5,904 @@
  *      Author: Shcheblykin
  */
 #include <avr/io.h>
-#include <util/delay.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "../inc/TFlashCrc.h"
 #include "../inc/TTests.h"
 
 /**	Структура FSM для тестов.
  *
- *
+ *	Таблица хранится во flash. Функции тестов вызываются напрямую из
+ *	runTest(), поэтому при добавлении теста надо дополнить и ее.
  */
-const TTests::SStateFSM TTests::FSM[TEST_MAX] = { 					//
-		{ &TTests::testError, 	{TEST_SOUT_BUS, TEST_SOUT_BUS} },	//
-		{ &TTests::testSoutBus, {TEST_PLIS_REG, TEST_SOUT_BUS} },	//
-		{ &TTests::testRegPlis, {TEST_DATA_BUS, TEST_PLIS_REG} }, 	//
-		{ &TTests::testDataBus, {TEST_FRAM,	    TEST_DATA_BUS} }, 	//
-		{ &TTests::testFram, 	{TEST_2RAM, 	TEST_FRAM    } }, 	//
-		{ &TTests::test2Ram,	{TEST_EXT_BUS,	TEST_2RAM 	 } },	//
-		{ &TTests::testExtBus,  {TEST_EXT_BUS,  TEST_EXT_BUS } } 	//
+const TTests::SStateFSM TTests::FSM[TEST_MAX] PROGMEM = { 		//
+		{ STEP_VISUAL, {TEST_SOUT_BUS, TEST_SOUT_BUS} },	// TEST_ERROR
+		{ STEP_VISUAL, {TEST_PLIS_REG, TEST_SOUT_BUS} },	// TEST_SOUT_BUS
+		{ STEP_FAST,   {TEST_DATA_BUS, TEST_PLIS_REG} }, 	// TEST_PLIS_REG
+		{ STEP_FAST,   {TEST_FRAM,	   TEST_DATA_BUS} }, 	// TEST_DATA_BUS
+		{ STEP_FAST,   {TEST_2RAM, 	   TEST_FRAM    } }, 	// TEST_FRAM
+		{ STEP_FAST,   {TEST_EXT_BUS,  TEST_2RAM 	} },	// TEST_2RAM
+		{ STEP_VISUAL, {TEST_EXT_BUS,  TEST_EXT_BUS } },	// TEST_EXT_BUS
+		{ STEP_FAST,   {TEST_SOUT_BUS, TEST_SOUT_BUS} },	// TEST_BUS_BENCH
+		{ STEP_FAST,   {TEST_SOUT_BUS, TEST_SOUT_BUS} } 	// TEST_STRESS
 };
 
+/**	Карта регистров ПЛИС.
+ *
+ *	Таблица хранится во flash. BusR не проверяется - его значение зависит
+ *	от BusW и ExtSet, он проверяется в testDataBus().
+ */
+const TTests::TPlisRegTest::SReg TTests::PLIS_REG[] PROGMEM = {
+		{ offsetof(SPlisRegister, init),	1, 0x00FF, REG_INIT_FRAM_DISABLE },
+		{ offsetof(SPlisRegister, vers),	1, 0x0000, 0x00FF },
+		{ offsetof(SPlisRegister, dd),		2, 0xFFFF, 0x0000 },
+		{ offsetof(SPlisRegister, curAdr),	1, 0x00FF, 0x0000 },
+		{ offsetof(SPlisRegister, extSet),	1, 0x00FF, 0x0000 },
+		{ offsetof(SPlisRegister, busW),	1, 0x00FF, 0x0000 },
+		{ offsetof(SPlisRegister, bankFl),	1, 0x00FF, 0x0000 },
+		{ 0, 0, 0, 0 }
+};
 
-const uint8_t TTests::crc8[256] PROGMEM = {
-    0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83,
-    0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
-    0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E,
-    0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC,
-    0x23, 0x7D, 0x9F, 0xC1, 0x42, 0x1C, 0xFE, 0xA0,
-    0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
-    0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D,
-    0x7C, 0x22, 0xC0, 0x9E, 0x1D, 0x43, 0xA1, 0xFF,
-    0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5,
-    0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07,
-    0xDB, 0x85, 0x67, 0x39, 0xBA, 0xE4, 0x06, 0x58,
-    0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
-    0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6,
-    0xA7, 0xF9, 0x1B, 0x45, 0xC6, 0x98, 0x7A, 0x24,
-    0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B,
-    0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9,
-    0x8C, 0xD2, 0x30, 0x6E, 0xED, 0xB3, 0x51, 0x0F,
-    0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
-    0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92,
-    0xD3, 0x8D, 0x6F, 0x31, 0xB2, 0xEC, 0x0E, 0x50,
-    0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C,
-    0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE,
-    0x32, 0x6C, 0x8E, 0xD0, 0x53, 0x0D, 0xEF, 0xB1,
-    0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
-    0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49,
-    0x08, 0x56, 0xB4, 0xEA, 0x69, 0x37, 0xD5, 0x8B,
-    0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4,
-    0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16,
-    0xE9, 0xB7, 0x55, 0x0B, 0x88, 0xD6, 0x34, 0x6A,
-    0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
-    0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7,
-    0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35
+/**	Значения XDIV для подбора тактов ожидания внешней шины.
+ *
+ *	Частота МК без деления, 1/2 и 1/4 (делитель 129 - XDIV6..0).
+ */
+const uint8_t TTests::BUS_XDIV[BUS_DIV_MAX] PROGMEM = {
+		0,
+		(1 << XDIVEN) | (129 - 2),
+		(1 << XDIVEN) | (129 - 4)
 };
 
 // Тело класса
-void TTests::main() {
-		uint8_t next = 0;
+bool TTests::main() {
+	uint8_t next = FSM_NEXT_BUSY;
+
+	rstExtWdt();
+	countTicks();
+
+	if (Report.receive()) {
+		runCmd();
+	}
 
-		next = (this->*FSM[curTest].test)(next % FSM_NEXT_MAX);
-		curTest = FSM[curTest].next[next];
+	if (isPlanDone()) {
+		// после окончания плана тесты не выполняются, ждем команду
+		flag = false;
+	} else if (isSoutWait()) {
+		// время ожидания относится к выводу на шину SOut, а не к тесту
+		flag = false;
+		countTicks();
+		testTicks = 0;
+		testStart = TStat::now();
+	} else if ((cnt == 0) || isFullRate() || isStep(period)) {
+		uint32_t start = TStat::now();
+		uint32_t bus = TStat::getBus();
+
+		// запись ошибок хранится до начала следующего теста
+		if (cnt == 0) {
+			failLog.clear();
+		}
+
+		next = runTest(curTest, cnt++);
+
+		testBusy += TStat::now() - start;
+		testBus += TStat::getBus() - bus;
+
+		if (next == FSM_NEXT_BUSY) {
+			saveCheckpoint();
+		} else {
+			bool err = (next == FSM_NEXT_ERROR);
+			resumes = 0;
+			countTicks();
+			saveStat();
+			Report.sendResult(curTest, err ? error : 0, failAdr, testTicks);
+			if (failLog.getFails() != 0) {
+				Report.sendFail(curTest, failLog);
+			}
+			Report.sendStat(curTest, stat->test[curTest].busy,
+					stat->test[curTest].wait, stat->test[curTest].bus);
+		}
+
+		// код ошибки выводится в фоне, переход по ошибке не ждет
+		if ((next == FSM_NEXT_ERROR) && errorDwell) {
+			Seq.play(TSoutSeq::ERROR_CODE, error);
+		}
+	}
+
+	if (next != FSM_NEXT_BUSY) {
+		if (stat->plan.first != TEST_ERROR) {
+			setTest(getPlanNext(next == FSM_NEXT_ERROR));
+		} else {
+			setTest(getNext(curTest, next % FSM_NEXT_MAX));
+		}
+	}
+
+	return (next != FSM_NEXT_BUSY);
 }
 
+// Переход к тесту
+void TTests::setTest(TESTS test) {
+	curTest = test;
+	period = getPeriod(test);
+	cnt = 0;
+	tick = 0;
+	failAdr = 0;
+	testTicks = 0;
+	testStart = TStat::now();
+	testBusy = 0;
+	testBus = 0;
+	saveCheckpoint();
+}
 
-/**	Тест шины SOut
+/**	Продолжение тестов после сброса МК.
  *
- *	Визуальная проверка шины внешних сигналов (авария, предупреждение и т.д).
- * 	Поочередно устаналиваются сигналы на каждом из выходов.
- *	Повторяется дважды.
+ *	Если контрольная точка цела и МК сброшен не по включению питания, тесты
+ *	продолжаются с начала прерванного теста, иначе начинаются с
+ *	TEST_SOUT_BUS. Шаги теста зависят от предыдущих (например, в тестах
+ *	памяти), поэтому тест повторяется целиком. Причина сброса и контрольная
+ *	точка передаются кадром TReport::TYPE_RESET.
+ *
+ *	Если тест уже продолжался RESUME_MAX раз подряд, он сбрасывает МК
+ *	(например, зависает до срабатывания сторожевого таймера). Такой тест
+ *	не продолжается, а заканчивается с ошибкой RESUME_ERROR (кадр
+ *	TReport::TYPE_RESULT): в плане - как тест с ошибкой, без плана -
+ *	переходом к TEST_ERROR.
+ *
+ *	План тестов продолжается вместе с контрольной точкой, если цела его
+ *	CRC, иначе сбрасывается.
  *
- *	@param value Не используется.
- *	@return Всегда 0.
+ *	@param cause Причина сброса, значение MCUCSR.
+ *	@return True - тесты продолжены с контрольной точки (в том числе
+ *	переходом по ошибке зависшего теста).
  */
-uint8_t TTests::testSoutBus(uint8_t value) {
-	uint8_t step = 16;
+bool TTests::resume(uint8_t cause) {
+	const SCheckpoint &c = stat->check;
+	bool valid = (getCheckCrc(c) == c.crc) && (c.test > TEST_ERROR) &&
+			(c.test < TEST_MAX);
+	bool resumed = valid && !(cause & (1 << PORF));
+	bool hung = resumed && (c.resumes >= RESUME_MAX);
+
+	Report.sendReset(cause, resumed && !hung, valid ? c.test : 0,
+			valid ? c.step : 0, valid ? c.error : 0, valid ? c.resumes : 0);
+
+	const SPlan &p = stat->plan;
+	if (!resumed || (getPlanCrc(p) != p.crc)) {
+		clearPlan();
+	}
 
-	while (step) {
-		rstExtWdt();
+	resumes = (resumed && !hung) ? c.resumes + 1 : 0;
+	setTest(resumed ? static_cast<TESTS> (c.test) : TEST_SOUT_BUS);
 
-		if (flag) {
-			flag = false;
-			step--;
-			SOut.setValue(1 << (step % 8));
+	if (hung) {
+		error = RESUME_ERROR;
+		Report.sendResult(curTest, error, 0, 0);
+		if (stat->plan.first != TEST_ERROR) {
+			setTest(getPlanNext(true));
+		} else {
+			setTest(TEST_ERROR);
 		}
 	}
 
-	return FSM_NEXT_NO_ERROR;
+	return resumed;
 }
 
-/**	Вывод сообщения об ошибке в тесте.
+// Выбор плана тестов
+bool TTests::setPlan(uint8_t first, uint8_t last, uint16_t count,
+		uint8_t flags) {
+	bool valid = (first == TEST_ERROR);
+
+	// последний тест достижим из первого по переходам без ошибки
+	if ((first > TEST_ERROR) && (first < TEST_MAX) &&
+			(last > TEST_ERROR) && (last < TEST_MAX)) {
+		TESTS t = static_cast<TESTS> (first);
+
+		for(uint8_t i = 0; (i < TEST_MAX) && !valid; i++) {
+			valid = (t == last);
+			t = getNext(t, FSM_NEXT_NO_ERROR);
+		}
+	}
+
+	if (valid) {
+		SPlan &p = stat->plan;
+
+		// прерванный тест мог оставить нагрузку на шину и разрешенную FRAM
+		if (cnt != 0) {
+			Stress.stop();
+			TStat::write(plis->init, REG_INIT_FRAM_DISABLE);
+		}
+
+		clearPlan();
+		if (first != TEST_ERROR) {
+			p.count = count;
+			p.first = first;
+			p.last = last;
+			p.flags = flags & ~PLAN_DONE;
+			p.crc = getPlanCrc(p);
+		}
+		planMask = 0;
+		planTicks = 0;
+		planBus = 0;
+		setTest((first != TEST_ERROR) ? static_cast<TESTS> (first) :
+				TEST_SOUT_BUS);
+	}
+
+	sendPlan();
+
+	return valid;
+}
+
+/**	Следующий тест плана.
  *
- *	В течении нескольких секунд на шину SOut выводится код ошибки.
+ *	Законченный тест учитывается в итерации. После последнего теста
+ *	итерации (или теста с ошибкой при PLAN_STOP_ON_FAIL) итерация
+ *	засчитывается и передается кадром TReport::TYPE_PLAN. Если план
+ *	закончен, на SOut выводится его результат.
  *
- *	@param value Код ошибки.
- *	@return Всегда 0.
+ *	@param err True - тест закончился с ошибкой.
+ *	@return Номер следующего теста.
  */
-uint8_t TTests::testError(uint8_t value=0) {
-	uint8_t step = 5;
+TTests::TESTS TTests::getPlanNext(bool err) {
+	SPlan &p = stat->plan;
+	bool stop = err && (p.flags & PLAN_STOP_ON_FAIL);
+
+	planTicks += testTicks;
+	planBus += testBus;
+	if (err) {
+		planMask |= (1 << curTest);
+	}
 
-	SOut.setValue(value);
+	if ((curTest != p.last) && !stop)
+		return getNext(curTest, FSM_NEXT_NO_ERROR);
 
-	while(step) {
-		rstExtWdt();
+	p.iter++;
+	if (planMask != 0) {
+		p.failed++;
+	}
+	if (stop || ((p.count != 0) && (p.iter >= p.count))) {
+		p.flags |= PLAN_DONE;
+	}
+	p.crc = getPlanCrc(p);
 
-		if (flag) {
-			flag = false;
-			step--;
-		}
+	sendPlan();
+	planMask = 0;
+	planTicks = 0;
+	planBus = 0;
+
+	if (p.flags & PLAN_DONE) {
+		Seq.stop();
+		SOut.setValue((p.failed != 0) ? POST_SOUT_FAIL : POST_SOUT_PASS);
+	}
+
+	return static_cast<TESTS> (p.first);
+}
+
+/**	Выполнение принятой команды.
+ *
+ *	Неизвестные команды и команды с неверной длиной пропускаются.
+ */
+void TTests::runCmd() {
+	const uint8_t *d = Report.getCmdData();
+
+	if ((Report.getCmdType() == TReport::CMD_PLAN) &&
+			(Report.getCmdLen() >= 5)) {
+		setPlan(d[0], d[1], d[2] | (d[3] << 8), d[4]);
+	}
+}
+
+/**	Кадр действующего плана.
+ *
+ *	Счетчики последней итерации передаются до их обнуления.
+ */
+void TTests::sendPlan() {
+	const SPlan &p = stat->plan;
+
+	Report.sendPlan(p.first, p.last, p.flags, p.count, p.iter, p.failed,
+			planMask, planTicks, planBus);
+}
+
+/**	Сохранение контрольной точки FSM.
+ *
+ *	Сброс МК во время записи портит CRC, тогда тесты начнутся сначала.
+ */
+void TTests::saveCheckpoint() {
+	SCheckpoint &c = stat->check;
+
+	c.test = curTest;
+	c.step = cnt;
+	c.error = (cnt != 0) ? error : 0;
+	c.resumes = resumes;
+	c.crc = getCheckCrc(c);
+}
+
+/**	Сохранение статистики законченного теста в блок статистики.
+ *
+ *	Время ожидания - все время теста, кроме выполнения его шагов.
+ */
+void TTests::saveStat() {
+	SStatTest &s = stat->test[curTest];
+
+	s.busy = testBusy;
+	s.wait = (TStat::now() - testStart) - testBusy;
+	s.bus = testBus;
+	s.runs++;
+}
+
+/**	Выполнение шага теста.
+ *
+ *	Функции тестов вызываются напрямую, без указателей на функции-члены.
+ *
+ *	@param test Номер теста.
+ *	@param step Номер шага.
+ *	@return Результат шага теста.
+ */
+uint8_t TTests::runTest(TESTS test, uint8_t step) {
+	uint8_t next = FSM_NEXT_NO_ERROR;
+
+	switch(test) {
+		case TEST_ERROR:	next = testError(step);		break;
+		case TEST_SOUT_BUS:	next = testSoutBus(step);	break;
+		case TEST_PLIS_REG:	next = testRegPlis(step);	break;
+		case TEST_DATA_BUS:	next = testDataBus(step);	break;
+		case TEST_FRAM:		next = testFram(step);		break;
+		case TEST_2RAM:		next = test2Ram(step);		break;
+		case TEST_EXT_BUS:	next = testExtBus(step);	break;
+		case TEST_BUS_BENCH:next = testBusBench(step);	break;
+		case TEST_STRESS:	next = testStress(step);	break;
+		case TEST_MAX:		break;
 	}
 
-	return FSM_NEXT_NO_ERROR;
+	return next;
+}
+
+/**	Тест шины SOut
+ *
+ *	Визуальная проверка шины внешних сигналов (авария, предупреждение и т.д).
+ * 	Поочередно устаналиваются сигналы на каждом из выходов.
+ *	Повторяется дважды.
+ *
+ *	Сигналы переключаются в прерывании таймера (TSoutSeq::WALK), тест
+ *	ждет окончания последовательности. В режиме совмещения (setOverlap())
+ *	тест заканчивается сразу, последовательность идет в фоне.
+ *
+ *	@param step Номер шага.
+ *	@return Всегда 0 по окончании теста.
+ */
+uint8_t TTests::testSoutBus(uint8_t step) {
+	if (step == 0) {
+		Seq.play(TSoutSeq::WALK, 0);
+	}
+
+	if (overlap)
+		return FSM_NEXT_NO_ERROR;
+
+	return Seq.isBusy() ? FSM_NEXT_BUSY : FSM_NEXT_NO_ERROR;
+}
+
+/**	Вывод сообщения об ошибке в тесте.
+ *
+ *	В течении нескольких секунд на шину SOut выводится код ошибки \a error.
+ *
+ *	@param step Номер шага.
+ *	@return Всегда 0 по окончании вывода.
+ */
+uint8_t TTests::testError(uint8_t step) {
+	if (step == 0) {
+		Seq.play(TSoutSeq::ERROR_CODE, error);
+	}
+
+	return Seq.isBusy() ? FSM_NEXT_BUSY : FSM_NEXT_NO_ERROR;
 }
 
 /** Тестирование ПЛИС.
  *
- *	Производится проверка регистров ПЛИС доступных для записи и(или) чтения:
- *	- проверка версии прошивки Vers(чтение);
- *	- проверка регистра ExtSet (запись/чтение);
- *	- проверка регистра Init (запись/чтение);
- *	- проверка корректности адресов, в регистры доступные на чтение и запись
- * 	последовательно записываются чилсла, а после этого так же последовательно
- *	происходит проверка их содержимого.
- *	Повторяется 4 раза.
+ *	Регистры ПЛИС проверяются по карте PLIS_REG за один шаг (TRegTest):
+ *	- версия прошивки Vers (только чтение, дважды считывается без записи);
+ *	- регистры записи/чтения Init, DD, CurAdr, ExtSet, BusW, BankFl
+ *	бегущими единицей и нулем;
+ *	- корректность адресов, во все регистры записываются различные числа,
+ *	а затем проверяется их содержимое.
+ *	Ошибочные разряды записываются в failLog по адресам регистров.
  *
- * 	@param value Не используется.
- *	@return Код ошибки. Каждый установленный бит отвечает за отдельную ошибку.
- *	@retval 0-бит Версия прошивки Vers.
- *	@retval 1-бит Регистр ExtSet.
- *	@retval 2-бит Регистр Init.
- *	@retval 3-бит Последовательная запись/чтение.
+ * 	@param step Номер шага.
+ *	@return Результат шага теста, по окончании теста в \a error код ошибки.
+ *	Каждый установленный бит отвечает за отдельную ошибку.
+ *	@retval 0-бит Регистр только чтения (Vers).
+ *	@retval 1-бит Бегущая единица.
+ *	@retval 2-бит Бегущий ноль.
+ *	@retval 3-бит Адресация регистров.
  */
-uint8_t TTests::testRegPlis(uint8_t value=0) {
-	uint8_t step = 4;
-	uint8_t error = 0;
-	volatile uint8_t tmp = 0;
+uint8_t TTests::testRegPlis(uint8_t step) {
+	if (step == 0) {
+		error = 0;
+		Seq.show(TSoutSeq::PROGRESS, TEST_PLIS_REG);
+		return FSM_NEXT_BUSY;
+	}
 
-	SOut.setValue(TEST_PLIS_REG);
+	error = TPlisRegTest::run(PLIS_REG, failLog);
 
-	while (step) {
-		rstExtWdt();
+	return (error > 0 ? FSM_NEXT_ERROR : FSM_NEXT_NO_ERROR);
+}
 
-		if (flag) {
-			flag = false;
-			step--;
-			SOut.tglMask(TEST_PLIS_REG);
+// Подбор тактов ожидания внешней шины
+void TTests::sweepBus() {
+	uint8_t wait = getWait();
+	uint8_t div[BUS_DIV_MAX];
 
-			// проверка версии прошивки Vers
-			for (uint_fast8_t i = 0; i < 8; i++) {
-				tmp = plis->vers;
-				if (tmp != 255)
-					error |= (1 << 0);
-			}
+	// смена частоты МК во время передачи исказит байт
+	Report.flush();
 
-			// проверка регистра ExtSet
-			for (uint8_t i = 1; i > 0; i <<= 1) {
-				plis->extSet = i;
-				tmp = plis->extSet;
-				if (tmp != i)
-					error |= (1 << 1);
-			}
+	for(uint8_t d = 0; d < BUS_DIV_MAX; d++) {
+		uint8_t xdiv = pgm_read_byte(&BUS_XDIV[d]);
 
-			// проверка регистра Init
-			for (uint8_t i = 1; i > 0; i <<= 1) {
-				plis->init = static_cast<REG_INIT> (i);
-				tmp = plis->init;
-				if (tmp != i)
-					error |= (1 << 2);
+		div[d] = getSweepDiv(d);
+		for(uint8_t a = 0; a < BUS_AREA_MAX; a++) {
+			sweep[a][d] = 0;
+			for(uint8_t w = 0; w < BUS_WAIT_MAX; w++) {
+				rstExtWdt();
+				if (checkArea(a, xdiv, w)) {
+					sweep[a][d] |= (1 << w);
+				}
 			}
+		}
+	}
+	failLog.clear();
+
+	Report.sendSweep(wait, div, BUS_DIV_MAX, &sweep[0][0], BUS_AREA_MAX);
+}
 
-			// проверка корректности адресов
-			plis->init = static_cast<REG_INIT> (11);
-			plis->curAdr = 22;
-			plis->extSet = 44;
-			plis->busW = 88;
-			plis->bankFl = 255;
+// Быстрая самопроверка при запуске
+uint8_t TTests::post() {
+	uint32_t start = TStat::now();
+	uint32_t bus = TStat::getBus();
+	uint8_t err = 0;
 
-			if (plis->init != 11)
-				error |= (1 << 3);
+	failLog.clear();
 
-			if (plis->curAdr != 22)
-				error |= (1 << 3);
-			plis->curAdr = 0;
+	// регистры ПЛИС, после проверки FRAM запрещена
+	if (TPlisRegTest::run(PLIS_REG, failLog) != 0) {
+		err |= (1 << 0);
+	}
 
-			if (plis->extSet != 44)
-				error |= (1 << 3);
-			plis->extSet = 0;
+	// шины BusW -> BusR: бегущие единица и ноль
+	TStat::write(plis->extSet, (0 << 3) | (1 << 2));		// BL -> 0
+	uint8_t prev = TStat::read(plis->busW);
+	for(uint8_t i = 0; i < 16; i++) {
+		uint8_t val = 1 << (i % 8);
+		if (i >= 8) {
+			val = ~val;
+		}
 
-			if (plis->bankFl != 255)
-				error |= (1 << 3);
-			plis->bankFl = 0;
+		uint32_t t = TStat::now();
+		TStat::write(plis->busW, val);
+		if (!waitBusR(val, val ^ prev, t)) {
+			err |= (1 << 1);
+		}
+		prev = val;
+	}
+	TStat::clear(plis->extSet, (0 << 3) | (1 << 2));		// BL -> 1
+	rstExtWdt();
+
+	// при неисправных линиях выборка ячеек не нужна
+	TStat::write(plis->init, REG_INIT_FRAM_ENABLE);
+	if (lineCheck<FLASH_ADR, FLASH_SIZE> () != 0) {
+		err |= (1 << 2);
+	} else {
+		// на следующем запуске - следующая часть FRAM
+		volatile EXT_REG(uint8_t) *boot =
+				extPtr<EXT_REG(uint8_t)> (POST_BOOT_ADR);
+		uint8_t part = TStat::read(*boot);
+
+		if (memSample<FLASH_ADR, FLASH_SIZE> (part) != 0) {
+			err |= (1 << 4);
 		}
+		TStat::write(*boot, part + 1);
 	}
+	TStat::write(plis->init, REG_INIT_FRAM_DISABLE);
+	rstExtWdt();
 
-	if (error) {
-		printError(error);
+	if (lineCheck<RAM_ADR, RAM_SIZE> () != 0) {
+		err |= (1 << 3);
+	} else if (memSample<RAM_ADR, RAM_SIZE> (0) != 0) {
+		err |= (1 << 5);
 	}
+	rstExtWdt();
 
-	return (error > 0 ? FSM_NEXT_ERROR : FSM_NEXT_NO_ERROR);
+	uint32_t cycles = TStat::now() - start;
+	SOut.setValue((err != 0) ? POST_SOUT_FAIL : POST_SOUT_PASS);
+	Report.sendPost(err, cycles, TStat::getBus() - bus);
+
+	return err;
+}
+
+// Проверка CRC программы во flash МК
+bool TTests::checkFlash() {
+	uint32_t start = TStat::now();
+	TFlashCrc fc;
+
+	if (fc.begin()) {
+		while (!fc.next(EXT_WDT_BLOCK)) {
+			rstExtWdt();
+		}
+	}
+
+	Report.sendFlash(fc.getResult(), fc.getLen(), fc.getCrc(),
+			TStat::now() - start);
+
+	if (fc.getResult() == TFlashCrc::RESULT_BAD) {
+		SOut.setValue(POST_SOUT_FAIL);
+		return false;
+	}
+
+	return true;
+}
+
+/**	Короткая проверка области внешней шины.
+ *
+ *	Проверка выполняется с заданными делителем частоты и тактами
+ *	ожидания, затем они восстанавливаются и в регистры ПЛИС записываются
+ *	значения из карты PLIS_REG (запрет FRAM).
+ *
+ *	Прерывания запрещаются только на время проверки: она короче тика
+ *	Timer1 и периода переполнения Timer3, поэтому их прерывания ждут
+ *	окончания проверки, а не теряются (см. TStat::now()).
+ *
+ *	@param area Область шины (BUS_AREA).
+ *	@param xdiv Значение XDIV.
+ *	@param wait Такты ожидания, 0..3.
+ *	@return True - проверка прошла.
+ */
+bool TTests::checkArea(uint8_t area, uint8_t xdiv, uint8_t wait) {
+	uint8_t oldWait = getWait();
+	uint8_t oldXdiv = XDIV;
+	uint8_t sreg = SREG;
+	bool pass = false;
+
+	if (area == BUS_AREA_FRAM) {
+		TStat::write(plis->init, REG_INIT_FRAM_ENABLE);
+	}
+
+	cli();
+	setXdiv(xdiv);
+	setWait(wait);
+	switch(area) {
+		case BUS_AREA_2RAM:
+			pass = (TLineTest<RAM_ADR, RAM_SIZE>::dataLines() == 0) &&
+					(TLineTest<RAM_ADR, RAM_SIZE>::adrLines() == 0);
+			break;
+		case BUS_AREA_FRAM:
+			pass = (TLineTest<FLASH_ADR, FLASH_SIZE>::dataLines() == 0) &&
+					(TLineTest<FLASH_ADR, FLASH_SIZE>::adrLines() == 0);
+			break;
+		case BUS_AREA_PLIS:
+			pass = (TPlisRegTest::run(PLIS_REG, failLog) == 0);
+			break;
+	}
+	setWait(oldWait);
+	setXdiv(oldXdiv);
+	SREG = sreg;
+
+	TPlisRegTest::reset(PLIS_REG);
+
+	return pass;
 }
 
 /**	Тестирование шин BUSW и BUSR.
  *
  *	На шину BUSW выставляется значение и сравнивается со считанным с BUSR.
+ *	Вместо фиксированной задержки BusR опрашивается до получения
+ *	ожидаемого значения два раза подряд, но не дольше DATA_BUS_TIMEOUT_US.
+ *	Время установления, в тактах МК, учитывается для каждого изменившегося
+ *	разряда, наибольшее значение сохраняется в \a settle и по окончании
+ *	теста передается кадром TReport::TYPE_SETTLE.
+ *	Повторяется 4 раза.
  *
- *	@param value Не используется.
- *	@return Код ошибки. Каждый установленный бит отвечает за отдельную ошибку.
+ *	@param step Номер шага.
+ *	@return Результат шага теста, по окончании теста в \a error код ошибки.
+ *	Каждый установленный бит отвечает за отдельную ошибку.
  *	@retval 0-бит Ошибка записи/чтения регистра BusW.
- *	@retval 1-бит Значение регистра BusR не совпало с установленным в BusW.
+ *	@retval 1-бит Значение регистра BusR не установилось за
+ *	DATA_BUS_TIMEOUT_US.
  */
-uint8_t TTests::testDataBus(uint8_t value=0) {
-	uint8_t step = 4;
-	uint8_t error = 0;
-	volatile uint8_t tmp = 0;
+uint8_t TTests::testDataBus(uint8_t step) {
+	uint8_t prev = 0;
 
-	SOut.setValue(TEST_DATA_BUS);
+	if (step == 0) {
+		error = 0;
+		for(uint8_t bit = 0; bit < 8; bit++) {
+			settle[bit] = 0;
+		}
+		Seq.show(TSoutSeq::PROGRESS, TEST_DATA_BUS);
 
-	// разрешение работы с внешними устройствами
-	plis->extSet = (0 << 3) | (1 << 2);		// BL -> 0
+		// разрешение работы с внешними устройствами
+		TStat::write(plis->extSet, (0 << 3) | (1 << 2));		// BL -> 0
+		return FSM_NEXT_BUSY;
+	}
 
-	while (step) {
-		rstExtWdt();
+	// разряды, измененные первой записью, неизвестны
+	prev = TStat::read(plis->busW);
 
-		if (flag) {
-			flag = false;
-			step--;
-			SOut.tglMask(TEST_DATA_BUS);
-
-
-			for (uint8_t i = 0; i < 255; i++) {
-				plis->busW = i;
-
-				// проерка значения записанного в регистр BusW ПЛИС
-				tmp = plis->busW;
-				if (tmp != i)
-					error |= (1 << 0);
-				_delay_us(10);
-
-				// проверка значения на шине BusR
-				tmp = plis->busR;
-				// на проверочной плате BUSW0 -> BUSR3, .., BUSW3 -> BUSR0
-				uint8_t t = (tmp & 0xF0); // старшие разряды остаются как были
-				t += ((tmp & 1) << 3); // BUSW0 -> BUSR3
-				t += ((tmp & 2) << 1); // BUSW1 -> BUSR2
-				t += ((tmp & 4) >> 1); // BUSW2 -> BUSR1
-				t += ((tmp & 8) >> 3); // BUSW3 -> BUSR0
-				if (t != i)
-					error |= (1 << 1);
-				_delay_us(40);
-			}
+	for (uint8_t i = 0; i < 255; i++) {
+		uint32_t start = TStat::now();
+		TStat::write(plis->busW, i);
+
+		// проерка значения записанного в регистр BusW ПЛИС
+		uint8_t w = TStat::read(plis->busW);
+		if (w != i) {
+			failLog.add(extAdr(&plis->busW), w ^ i);
+			error |= (1 << 0);
 		}
+
+		// проверка значения на шине BusR
+		if (!waitBusR(i, i ^ prev, start))
+			error |= (1 << 1);
+		prev = i;
 	}
 
+	if (step < 4)
+		return FSM_NEXT_BUSY;
+
 	// запрет работы с внешними устройствами
-	plis->extSet &= ~((0 << 3) | (1 << 2));		// BL -> 1
+	TStat::clear(plis->extSet, (0 << 3) | (1 << 2));		// BL -> 1
 
-	if (error) {
-		printError(error);
-	}
+	Report.sendSettle(US_TO_CYCLES(DATA_BUS_TIMEOUT_US), settle);
 
 	return (error > 0 ? FSM_NEXT_ERROR : FSM_NEXT_NO_ERROR);
 }
 
-/**	Тестирование чтения и записи памяти FRAM.
+/**	Ожидание установления значения на шине BusR после записи BusW.
  *
- *	Производится проверка всей памяти FRAM:
- *	- значение записанное в FRAM сразу же проверяется;
- *	- записывается вся память FRAM и затем проверяется.
- *	Проверка производится 4 раза.
+ *	BusR опрашивается до совпадения с ожидаемым значением два раза подряд.
+ *	Время установления изменившегося разряда - время первого опроса, с
+ *	которого разряд не отличается от ожидаемого. Наибольшее время по
+ *	каждому разряду сохраняется в \a settle, для не установившихся за
+ *	DATA_BUS_TIMEOUT_US разрядов - DATA_BUS_FAIL.
  *
- * 	@param value Не используется.
- *	@return Код ошибки. Каждый установленный бит отвечает за отдельную ошибку.
- *	@retval 0-бит Значение не совпало при считывании сразу после записи.
- *	@retval 1-бит Значение не совпало при считывании после записи всей FRAM.
+ *	@param val Значение, записанное в BusW.
+ *	@param diff Разряды BusW, измененные записью.
+ *	@param start Время записи, такт МК (TStat::now()).
+ *	@return True - значение BusR установилось.
  */
+bool TTests::waitBusR(uint8_t val, uint8_t diff, uint32_t start) {
+	const uint16_t timeout = US_TO_CYCLES(DATA_BUS_TIMEOUT_US);
+	uint8_t exp = getBusLoop(val);
+	uint8_t pend = diff;
+	uint16_t dt = 0;
+	uint8_t match = 0;
+
+	do {
+		uint8_t tmp = TStat::read(plis->busR);
+		dt = TStat::now() - start;
+
+		// перестановка разрядов обратима, ошибки в порядке разрядов BusW
+		uint8_t wrong = getBusLoop(tmp ^ exp);
+		uint8_t done = pend & ~wrong;
+		pend = (pend & ~done) | (wrong & diff);
+		for(uint8_t bit = 0; done != 0; bit++, done >>= 1) {
+			if ((done & 1) && (dt > settle[bit])) {
+				settle[bit] = dt;
+			}
+		}
 
-uint8_t TTests::testFram(uint8_t value=1) {
-	uint8_t val = 0;
-	uint8_t step = 5;
-	uint8_t error = 0;
-	volatile uint8_t * volatile const ptr = (uint8_t*) (FLASH_ADR);
+		match = (wrong == 0) ? match + 1 : 0;
+	} while ((match < 2) && (dt < timeout));
 
-	SOut.setValue(TEST_FRAM);
-	plis->init = REG_INIT_FRAM_ENABLE;
+	if (match < 2) {
+		failLog.add(extAdr(&plis->busR), pend);
+		for(uint8_t bit = 0; bit < 8; bit++) {
+			if (pend & (1 << bit)) {
+				settle[bit] = DATA_BUS_FAIL;
+			}
+		}
+	}
 
-	while(step) {
-		rstExtWdt();
+	return (match >= 2);
+}
 
-		if (flag) {
-			flag = false;
-			step--;
-			SOut.tglMask(TEST_FRAM);
-
-			// проверка чтение/запись одного байта данных
-			// ^ (i >> 8) - надо для того, чтобы в память не писались
-			// повторяющиеся куски кода
-			val = step;
-			for(uint16_t i = 0; i < FLASH_SIZE; i++) {
-				uint8_t tmp = val ^ i;
-				val = pgm_read_byte(&crc8[tmp]);
-				ptr[i] = val;
-				if (val != ptr[i]) {
-					error |= 1;
-				}
-				rstExtWdt();
-			}
+/**	Тестирование чтения и записи памяти FRAM.
+ *
+ *	Сначала проверяются линии данных и адреса FRAM (см. lineCheck()), при
+ *	их неисправности тест сразу заканчивается. Затем производится проверка
+ *	памяти FRAM алгоритмом \a memAlg (см. memStep()), кроме последней
+ *	ячейки - счетчика запусков самопроверки (POST_BOOT_ADR). Линии
+ *	адреса эту ячейку не затрагивают.
+ *
+ * 	@param step Номер шага.
+ *	@return Результат шага теста, по окончании теста в \a error код ошибки.
+ *	Каждый установленный бит отвечает за отдельную ошибку.
+ *	@retval 0-бит Значение не совпало при считывании сразу после записи.
+ *	@retval 1-бит Значение не совпало при считывании после записи всей FRAM.
+ *	@retval 2-бит Ошибка March-теста.
+ *	@retval 3-бит Неисправность линий данных.
+ *	@retval 4-бит Неисправность линий адреса.
+ */
+uint8_t TTests::testFram(uint8_t step) {
+	if (step == 0) {
+		error = 0;
+		Seq.show(TSoutSeq::PROGRESS, TEST_FRAM);
+		TStat::write(plis->init, REG_INIT_FRAM_ENABLE);
+		return FSM_NEXT_BUSY;
+	}
 
-			// проверка чтения всей памяти
-			val = step;
-			for(uint16_t i = 0; i < FLASH_SIZE; i++) {
-				uint8_t tmp = val ^ i;
-				val = pgm_read_byte(&crc8[tmp]);
-				if (val != ptr[i]) {
-					error |= 2;
-				}
-				rstExtWdt();
-			}
-		}
+	// при неисправных линиях данных/адреса полная проверка не нужна
+	if (step == 1) {
+		error |= lineCheck<FLASH_ADR, FLASH_SIZE> ();
 	}
 
-	plis->init = REG_INIT_FRAM_DISABLE;
+	if (!(error & MEM_ERROR_LINE)) {
+		error |= memStep<FLASH_ADR, FLASH_FSM_SIZE> (step);
 
-	if (error) {
-		printError(error);
+		if (step < getMemSteps())
+			return FSM_NEXT_BUSY;
 	}
 
+	TStat::write(plis->init, REG_INIT_FRAM_DISABLE);
+
 	return (error > 0 ? FSM_NEXT_ERROR : FSM_NEXT_NO_ERROR);
 }
 
 /**	Тестирование чтения и записи памяти 2RAM
  *
- *	Производится проверка 1к памяти 2RAM:
- *	- значение записанное в 2RAM сразу же проверяется;
- *	- записывается вся память 2RAM и затем проверяется.
- *	Проверка производится 4 раза.
+ *	Сначала проверяются линии данных и адреса 2RAM (см. lineCheck()), при
+ *	их неисправности тест сразу заканчивается. Затем производится проверка
+ *	всей памяти 2RAM алгоритмом \a memAlg (см. memStep()).
  *
- * 	@param value Не используется.
- *	@return Код ошибки. Каждый установленный бит отвечает за отдельную ошибку.
+ * 	@param step Номер шага.
+ *	@return Результат шага теста, по окончании теста в \a error код ошибки.
+ *	Каждый установленный бит отвечает за отдельную ошибку.
  *	@retval 0-бит Значение не совпало при считывании сразу после записи.
  *	@retval 1-бит Значение не совпало при считывании после записи всей 2RAM.
+ *	@retval 2-бит Ошибка March-теста.
+ *	@retval 3-бит Неисправность линий данных.
+ *	@retval 4-бит Неисправность линий адреса.
  */
-uint8_t TTests::test2Ram(uint8_t value=1) {
-	uint8_t val = 0;
-	uint8_t step = 5;
-	uint8_t error = 0;
-	volatile uint8_t * volatile const ptr = (uint8_t*) (RAM_ADR);
+uint8_t TTests::test2Ram(uint8_t step) {
+	if (step == 0) {
+		error = 0;
+		Seq.show(TSoutSeq::PROGRESS, TEST_2RAM);
+		return FSM_NEXT_BUSY;
+	}
 
-	SOut.setValue(TEST_2RAM);
+	// при неисправных линиях данных/адреса полная проверка не нужна
+	if (step == 1) {
+		error |= lineCheck<RAM_ADR, RAM_SIZE> ();
+	}
 
-	while(step) {
-		rstExtWdt();
+	if (!(error & MEM_ERROR_LINE)) {
+		error |= memStep<RAM_ADR, RAM_SIZE> (step);
 
-		if (flag) {
-			flag = false;
-			step--;
-			SOut.tglMask(TEST_2RAM);
-
-			// проверка чтение/запись одного байта данных
-			// ^ (i >> 8) - надо для того, чтобы в память не писались
-			// повторяющиеся куски кода
-			val = step;
-			for(uint16_t i = 0; i < RAM_SIZE; i++) {
-				uint8_t tmp = val ^ i;
-				val = pgm_read_byte(&crc8[tmp]);
-				ptr[i] = val;
-				if (val != ptr[i]) {
-					error |= 1;
-				}
-				rstExtWdt();
-			}
+		if (step < getMemSteps())
+			return FSM_NEXT_BUSY;
+	}
 
-			val = step;
-			// проверка чтения всей памяти
-			for(uint16_t i = 0; i < RAM_SIZE; i++) {
-				uint8_t tmp = val ^ i;
-				val = pgm_read_byte(&crc8[tmp]);
-				if (val != ptr[i]) {
-					error |= 2;
-				}
-				rstExtWdt();
-			}
+	return (error > 0 ? FSM_NEXT_ERROR : FSM_NEXT_NO_ERROR);
+}
+
+/**	Замер пропускной способности внешней шины.
+ *
+ *	В цепочку тестов FSM не входит, запускается после запуска МК при сборке
+ *	с -DBUS_BENCH=true (или setTest()), затем FSM переходит к
+ *	TEST_SOUT_BUS. На каждом шаге
+ *	для одной области шины (BUS_AREA) выполняются замеры всех видов
+ *	обращений TBusBench и передается кадр TReport::TYPE_BENCH. Регистр ПЛИС
+ *	замеряется на CurAdr, после замера в него записывается 0. Содержимое
+ *	2RAM и FRAM не сохраняется, кроме счетчика запусков самопроверки
+ *	(POST_BOOT_ADR).
+ *
+ *	@param step Номер шага.
+ *	@return Всегда 0 по окончании теста.
+ */
+uint8_t TTests::testBusBench(uint8_t step) {
+	static const uint16_t CUR_ADR = PLIS_ADR + offsetof(SPlisRegister, curAdr);
+	uint32_t cycles[TBusBench::KIND_MAX];
+	uint8_t area = step - 1;
+
+	if (step == 0) {
+		error = 0;
+		Seq.show(TSoutSeq::PROGRESS, TEST_BUS_BENCH);
+		return FSM_NEXT_BUSY;
+	}
+
+	volatile EXT_REG(uint8_t) *boot = extPtr<EXT_REG(uint8_t)> (POST_BOOT_ADR);
+	uint8_t part = 0;
+
+	// счетчик запусков самопроверки в FRAM восстанавливается после замера
+	if (area == BUS_AREA_FRAM) {
+		TStat::write(plis->init, REG_INIT_FRAM_ENABLE);
+		part = TStat::read(*boot);
+	}
+
+	for(uint8_t k = 0; k < TBusBench::KIND_MAX; k++) {
+		switch(area) {
+			case BUS_AREA_2RAM:
+				cycles[k] = TBusBench::run<RAM_ADR, RAM_SIZE - 1> (k);
+				break;
+			case BUS_AREA_FRAM:
+				cycles[k] = TBusBench::run<FLASH_ADR, FLASH_SIZE - 1> (k);
+				break;
+			default:
+				cycles[k] = TBusBench::run<CUR_ADR, 0> (k);
+				break;
+		}
+	}
+
+	if (area == BUS_AREA_FRAM) {
+		TStat::write(*boot, part);
+		TStat::write(plis->init, REG_INIT_FRAM_DISABLE);
+	} else if (area == BUS_AREA_PLIS) {
+		TStat::write(plis->curAdr, 0);
+	}
+
+	Report.sendBench(area, TBusBench::BYTES, cycles, TBusBench::KIND_MAX);
+
+	return (step < BUS_AREA_MAX) ? FSM_NEXT_BUSY : FSM_NEXT_NO_ERROR;
+}
+
+/**	Проверка FRAM при нагрузке на внешнюю шину.
+ *
+ *	В цепочку тестов FSM не входит, запускается после запуска МК при сборке
+ *	с -DBUS_STRESS=true (или setTest()), затем FSM переходит к
+ *	TEST_SOUT_BUS. Код ошибки выводится в фоне из main(), TEST_SOUT_BUS
+ *	дожидается его окончания. Проверка всей FRAM алгоритмом \a memAlg
+ *	(см. memStep()) проходится дважды: без нагрузки и с нагрузкой на шину
+ *	из прерывания Timer2 (TBusStress). По окончании передается кадр
+ *	TReport::TYPE_STRESS со временем проходов и счетчиками прерываний.
+ *
+ *	@param step Номер шага.
+ *	@return Результат шага теста, по окончании теста в \a error код ошибки.
+ *	Каждый установленный бит отвечает за отдельную ошибку.
+ *	@retval 0..2-бит Ошибки FRAM без нагрузки (см. testFram()).
+ *	@retval 5-бит Ошибка 2RAM в прерывании.
+ *	@retval 6-бит Ошибка регистра ПЛИС в прерывании.
+ *	@retval 7-бит Ошибка FRAM только при нагрузке.
+ */
+uint8_t TTests::testStress(uint8_t step) {
+	uint8_t steps = getMemSteps();
+	bool loaded = (step > steps);
+	uint32_t start;
+	uint8_t err;
+
+	if (step == 0) {
+		error = 0;
+		stressQuiet = 0;
+		stressLoaded = 0;
+		Seq.show(TSoutSeq::PROGRESS, TEST_STRESS);
+		TStat::write(plis->init, REG_INIT_FRAM_ENABLE);
+		return FSM_NEXT_BUSY;
+	}
+
+	if (step == steps + 1) {
+		Stress.start();
+	}
+
+	start = TStat::now();
+	err = memStep<FLASH_ADR, FLASH_FSM_SIZE> (loaded ? step - steps : step);
+	if (loaded) {
+		stressLoaded += TStat::now() - start;
+		if ((err != 0) && !(error & 0x07)) {
+			error |= (1 << 7);
 		}
+	} else {
+		stressQuiet += TStat::now() - start;
+		error |= err;
 	}
 
-	if (error) {
-		printError(error);
+	if (step < 2 * steps)
+		return FSM_NEXT_BUSY;
+
+	Stress.stop();
+	TStat::write(plis->init, REG_INIT_FRAM_DISABLE);
+
+	if (Stress.getRamErrors() != 0) {
+		error |= (1 << 5);
 	}
+	if (Stress.getRegErrors() != 0) {
+		error |= (1 << 6);
+	}
+
+	Report.sendStress(stressQuiet, stressLoaded, Stress.getCalls(),
+			Stress.getRamErrors(), Stress.getRegErrors());
 
 	return (error > 0 ? FSM_NEXT_ERROR : FSM_NEXT_NO_ERROR);
 }
@@ -401,58 +913,292 @@ uint8_t TTests::test2Ram(uint8_t value=1) {
  *
  *	Проверка - визуально. Считывание не проверяется.
  *
- *	@param value Не используется.
- *	@return Всегда 0.
+ *	@param step Номер шага.
+ *	@return Всегда 0 по окончании теста.
  */
-uint8_t TTests::testExtBus(uint8_t value=0) {
-	uint8_t step = 16;
+uint8_t TTests::testExtBus(uint8_t step) {
+	if (step == 0) {
+		Seq.show(TSoutSeq::PROGRESS, TEST_EXT_BUS);
+		return FSM_NEXT_BUSY;
+	}
+
+	uint8_t pos = 16 - step;
 
-	SOut.setValue(TEST_EXT_BUS);
+	// разрешим работу с внешними устройствами  и установим шину на записи
+	TStat::write(plis->extSet, (0 << 3) | (1 << 2));		// BL -> 0
+	TStat::set(plis->extSet, (1 << 4) | (1 << 0));		// Ext_RD -> 1
+	if (pos & 0x01) {
+		TStat::set(plis->extSet, 1 << 1);
+	}
+	TStat::write(plis->curAdr, 1 << (pos % 8));
+	TStat::write(plis->dd, 1 << (pos % 16));
+
+	return (step < 16) ? FSM_NEXT_BUSY : FSM_NEXT_NO_ERROR;
+}
 
-	while(step) {
+/**	Проверка области внешней памяти заданной последовательностью.
+ *
+ *	Область заполняется последовательностью \a TPattern, каждое записанное
+ *	значение сразу же проверяется. Затем проверяется вся область.
+ *
+ *	Если задана сигнатура \a TSig, при записи считается сигнатура
+ *	последовательности, а вся область проверяется чтением подряд с
+ *	вычислением сигнатуры. Побайтное сравнение с последовательностью
+ *	выполняется только при несовпадении сигнатур, для поиска адреса ошибки.
+ *
+ *	Внешний сторожевой таймер сбрасывается после каждого блока из
+ *	EXT_WDT_BLOCK байт, так что во внутренних циклах идут обращения только
+ *	к проверяемой памяти. Адрес первой ошибки (с точностью до пары байт)
+ *	сохраняется в \a failAdr, адреса и разряды всех ошибок - в \a failLog.
+ *
+ *	@param ptr Начало области.
+ *	@param size Размер области, четное число.
+ *	@param seed Начальное значение последовательности.
+ *	@return Код ошибки. Каждый установленный бит отвечает за отдельную ошибку.
+ *	@retval 0-бит Значение не совпало при считывании сразу после записи.
+ *	@retval 1-бит Значение не совпало при считывании после записи всей области.
+ */
+template <class TPattern, class TSig>
+uint8_t TTests::memTest(volatile EXT_REG(uint8_t) *ptr, uint16_t size,
+		uint8_t seed) {
+	uint8_t error = 0;
+	TPattern wr(seed);
+	TPattern rd(seed);
+	TSig wrSig;
+
+	// проверка чтение/запись двух байт данных
+	for(uint16_t i = 0; i < size; ) {
+		uint16_t end = getBlockEnd(i, size);
+
+		// запись и чтение каждого байта
+		TStat::addBus(2 * (end - i));
+		for(; i < end; i += 2) {
+			uint16_t val = wr.next();
+			ptr[i] = val;
+			ptr[i + 1] = val >> 8;
+			wrSig.add(val);
+			wrSig.add(val >> 8);
+			uint8_t v0 = ptr[i];
+			uint8_t v1 = ptr[i + 1];
+			if ((v0 != (uint8_t) val) || (v1 != (uint8_t) (val >> 8))) {
+				logPair(&ptr[i], v0 ^ val, v1 ^ (val >> 8));
+				error |= 1;
+			}
+		}
 		rstExtWdt();
+	}
 
-		if (flag) {
-			flag = false;
-			step--;
-			SOut.tglMask(TEST_EXT_BUS);
+	// проверка сигнатуры всей памяти
+	if (TSig::ENABLED) {
+		TSig rdSig;
 
-			// разрешим работу с внешними устройствами  и установим шину на записи
-			plis->extSet = (0 << 3) | (1 << 2);		// BL -> 0
-			plis->extSet |= (1 << 4) | (1 << 0);	// Ext_RD -> 1
-			if (step & 0x01) {
-				plis->extSet |= (1 << 1);
+		for(uint16_t i = 0; i < size; ) {
+			uint16_t end = getBlockEnd(i, size);
+
+			TStat::addBus(end - i);
+			for(; i < end; i++) {
+				rdSig.add(ptr[i]);
 			}
-			plis->curAdr = 1 << (step % 8);
-			plis->dd = 1 << (step % 16);
+			rstExtWdt();
 		}
+
+		if (rdSig.get() == wrSig.get())
+			return error;
+
+		error |= 2;
+	}
+
+	// проверка чтения всей памяти
+	for(uint16_t i = 0; i < size; ) {
+		uint16_t end = getBlockEnd(i, size);
+
+		TStat::addBus(end - i);
+		for(; i < end; i += 2) {
+			uint16_t val = rd.next();
+			uint8_t v0 = ptr[i];
+			uint8_t v1 = ptr[i + 1];
+			if ((v0 != (uint8_t) val) || (v1 != (uint8_t) (val >> 8))) {
+				logPair(&ptr[i], v0 ^ val, v1 ^ (val >> 8));
+				error |= 2;
+			}
+		}
+		rstExtWdt();
+	}
+
+	return error;
+}
+
+/**	Проверка области внешней памяти последовательностью шага теста.
+ *
+ *	На первых шагах проверяется псевдослучайная последовательность, на
+ *	последних двух - бегущая единица и шахматный порядок.
+ *
+ *	@param ptr Начало области.
+ *	@param size Размер области, четное число.
+ *	@param step Номер шага, начиная с 1.
+ *	@return Код ошибки теста памяти.
+ */
+template <class TSig>
+uint8_t TTests::memPattern(volatile EXT_REG(uint8_t) *ptr, uint16_t size,
+		uint8_t step) {
+	uint8_t seed = getMemSteps() - step;
+	uint8_t error = 0;
+
+	if (seed == 1) {
+		error = memTest<TPatternWalking, TSig> (ptr, size, seed);
+	} else if (seed == 0) {
+		error = memTest<TPatternChecker, TSig> (ptr, size, seed);
+	} else {
+		error = memTest<TPatternXorshift, TSig> (ptr, size, seed);
 	}
 
-	return FSM_NEXT_NO_ERROR;
+	return error;
 }
 
-/**	Вывод кода ошибки на шинц SOut.
+/**	Проверка области внешней памяти на очередном шаге теста.
  *
- *	Код ошибки выводится на несколько секунд.
+ *	Для алгоритма MEM_ALG_PATTERN проверяется последовательность шага
+ *	(см. memPattern()), побайтно или по сигнатуре в зависимости от
+ *	\a memVerify.
  *
- *	Во время вывода ошибки, программа крутится в этой функции.
+ *	Для March-тестов на каждом шаге используется свой фон: 0x00, 0x55, 0x33,
+ *	0x0F. Так обнаруживается и связность разрядов внутри байта.
  *
- *	@param value Код ошибки.
- *	@return Всегда 0.
+ *	@param step Номер шага, начиная с 1.
+ *	@return Код ошибки теста памяти.
  */
-uint8_t TTests::printError(uint8_t value) {
-	uint8_t step = 5;
+template <uint16_t ADR, uint16_t SIZE>
+uint8_t TTests::memStep(uint8_t step) {
+	static const uint8_t marchBg[4] PROGMEM = { 0x00, 0x55, 0x33, 0x0F };
+	volatile EXT_REG(uint8_t) * volatile const ptr =
+			extPtr<EXT_REG(uint8_t)> (ADR);
+	uint8_t error = 0;
+
+	switch(memAlg) {
+		case MEM_ALG_PATTERN: {
+			if (memVerify == MEM_VERIFY_SIGNATURE) {
+				error = memPattern<MEM_SIGNATURE> (ptr, SIZE, step);
+			} else {
+				error = memPattern<TSigNone> (ptr, SIZE, step);
+			}
+		} break;
+
+		case MEM_ALG_MATS_PLUS:
+		case MEM_ALG_MARCH_C:
+		case MEM_ALG_MARCH_B: {
+			MARCH alg = static_cast<MARCH> (memAlg - MEM_ALG_MATS_PLUS);
+			uint8_t bg = pgm_read_byte(&marchBg[(step - 1) % 4]);
+
+			uint16_t fail = TMarch<ADR, SIZE, RAM_ADR>::run(alg, bg, failLog);
+			if (fail != 0) {
+				setFailAdr(fail);
+				error |= (1 << 2);
+			}
+		} break;
+	}
 
-	SOut.setValue(value);
+	return error;
+}
 
-	while(step) {
-		rstExtWdt();
+/**	Проверка выборки ячеек области внешней памяти по сигнатуре.
+ *
+ *	В POST_SAMPLES ячеек, но не больше SIZE, с шагом POST_STRIDE
+ *	записывается последовательность TPatternXorshift, затем сигнатура
+ *	MEM_SIGNATURE считанных ячеек сравнивается с сигнатурой записанных. Побайтное
+ *	сравнение - только при несовпадении сигнатур, для записи адресов
+ *	ошибок в \a failLog.
+ *
+ *	Второй проход записывает инверсию последовательности, так что каждый
+ *	разряд выборки проверяется и нулем, и единицей.
+ *
+ *	Шаг POST_STRIDE нечетный, поэтому адреса с ним обходят всю область.
+ *	Если область больше POST_SAMPLES, обход делится на части по
+ *	POST_SAMPLES ячеек и проверяется часть \a part (по модулю кол-ва
+ *	частей).
+ *
+ *	@param part Номер части области.
+ *	@return 1 - ошибка, 0 - нет.
+ */
+template <uint16_t ADR, uint16_t SIZE>
+uint8_t TTests::memSample(uint8_t part) {
+	static const uint16_t n = (SIZE < POST_SAMPLES) ? SIZE : POST_SAMPLES;
+	volatile EXT_REG(uint8_t) *ptr = extPtr<EXT_REG(uint8_t)> (ADR);
+	const uint16_t start = static_cast<uint16_t> (
+			static_cast<uint16_t> (part * n) * POST_STRIDE) & (SIZE - 1);
+	uint8_t fail = 0;
+
+	for(uint8_t pass = 0; pass < 2; pass++) {
+		const uint8_t inv = (pass == 0) ? 0x00 : 0xFF;
+		TPatternXorshift wr(0);
+		MEM_SIGNATURE wrSig;
+		MEM_SIGNATURE rdSig;
+		uint16_t off = start;
+		uint16_t i;
+
+		for(i = 0; i < n; i++) {
+			uint8_t val = static_cast<uint8_t> (wr.next()) ^ inv;
+			ptr[off] = val;
+			wrSig.add(val);
+			off = (off + POST_STRIDE) & (SIZE - 1);
+		}
+
+		off = start;
+		for(i = 0; i < n; i++) {
+			rdSig.add(ptr[off]);
+			off = (off + POST_STRIDE) & (SIZE - 1);
+		}
+		TStat::addBus(2 * n);
+
+		if (MEM_SIGNATURE::ENABLED && (rdSig.get() == wrSig.get()))
+			continue;
+
+		TPatternXorshift rd(0);
+
+		off = start;
+		for(i = 0; i < n; i++) {
+			uint8_t bits = ptr[off] ^ static_cast<uint8_t> (rd.next()) ^ inv;
+			if (bits != 0) {
+				setFailAdr(ADR + off);
+				failLog.add(ADR + off, bits);
+				fail = 1;
+			}
+			off = (off + POST_STRIDE) & (SIZE - 1);
+		}
+		TStat::addBus(n);
+	}
+
+	return fail;
+}
+
+/**	Проверка линий данных и адреса области внешней памяти.
+ *
+ *	Линии адреса проверяются только при исправных линиях данных. Маски
+ *	неисправных линий сохраняются в \a lineData и \a lineAdr, в \a failAdr
+ *	начало области или адрес с неисправными линиями адреса. Неисправные
+ *	линии данных записываются в \a failLog разрядами начала области.
+ *
+ *	@return Код ошибки теста памяти.
+ *	@retval 3-бит Неисправность линий данных.
+ *	@retval 4-бит Неисправность линий адреса.
+ */
+template <uint16_t ADR, uint16_t SIZE>
+uint8_t TTests::lineCheck() {
+	uint8_t error = 0;
 
-		if (flag) {
-			flag = false;
-			step--;
+	lineAdr = 0;
+	lineData = TLineTest<ADR, SIZE>::dataLines();
+
+	if (lineData != 0) {
+		failAdr = ADR;
+		failLog.add(ADR, lineData);
+		error |= (1 << 3);
+	} else {
+		lineAdr = TLineTest<ADR, SIZE>::adrLines();
+		if (lineAdr != 0) {
+			failAdr = ADR + lineAdr;
+			error |= (1 << 4);
 		}
 	}
 
-	return 0;
+	return error;
 }